@@ -42,6 +42,7 @@
 #define CTH_RELEASE_NOEXCEPT noexcept(true)
 #define CTH_RELEASE_CONSTEXPR constexpr
 #endif
+#include <cstddef>
 #include <cstdint>
 
 namespace cth {
@@ -59,4 +60,10 @@ constexpr auto COMPILATION_MODE =
 
 consteval bool debug_mode() { return COMPILATION_MODE == CompilationMode::DEBUG; }
 
+/**
+ * assumed cache line size (in bytes) for false sharing avoidance
+ * @note std::hardware_destructive_interference_size is not reliably available / abi stable
+ */
+constexpr size_t CACHE_LINE_SIZE = 64;
+
 }
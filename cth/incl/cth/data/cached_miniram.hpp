@@ -0,0 +1,270 @@
+#pragma once
+#include "cth/constants.hpp"
+#include "cth/data/sharded_miniram.hpp"
+#include "cth/data/thread_caches.hpp"
+#include "cth/io/log.hpp"
+
+#include <array>
+#include <bit>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cth::dt {
+
+/**
+ * thread safe miniram, per thread small block caches (magazines) in front of a @ref basic_sharded_miniram
+ * @details
+ * - small requests are rounded up to size classes, freed small blocks stay in the freeing thread's magazine
+ *   of their class and are handed out again without touching shared state
+ * - a full magazine flushes half of its blocks to the shards in one batch
+ * - cached blocks stay allocated in the underlying ram, they count as allocated
+ * - caches of exited threads are kept until @ref flush_all()
+ * @note frees are sized, pass the size the block was requested with
+ */
+template<uint SizeType, uint IndexType>
+class basic_cached_miniram {
+public:
+    using ram_type = basic_sharded_miniram<SizeType, IndexType>;
+    using size_type = SizeType;
+    using index_type = IndexType;
+    using alloc_type = typename ram_type::alloc_type;
+    using defrag_type = typename ram_type::defrag_type;
+
+    static constexpr index_type INVALID_INDEX = ram_type::INVALID_INDEX;
+    static constexpr size_type NO_SPACE = ram_type::NO_SPACE;
+
+    /**
+     * largest cached request (in elements)
+     */
+    static constexpr size_type MAX_CACHED_SIZE = 256;
+    static constexpr size_t DEFAULT_MAGAZINE_CAPACITY = 64;
+
+private:
+    // 8 exact classes, then 4 classes per power of two
+    static constexpr size_t EXACT_CLASSES = 8;
+    static constexpr size_t CLASSES_PER_POW2 = 4;
+
+    [[nodiscard]] static constexpr size_t classIndex(size_type size);
+    [[nodiscard]] static constexpr size_type classSize(size_type size);
+
+    static constexpr size_t NUM_CLASSES = classIndex(MAX_CACHED_SIZE) + 1;
+
+    struct alignas(CACHE_LINE_SIZE) thread_cache {
+        std::array<std::vector<alloc_type>, NUM_CLASSES> magazines{};
+    };
+
+public:
+    /**
+     * constructs
+     * @param capacity of ram (in elements)
+     * @param shard_count see @ref basic_sharded_miniram
+     * @param magazine_capacity max cached blocks per thread and size class, >= 2
+     * @param initial_alloc_capacity per shard (in allocations), >= 1
+     */
+    explicit basic_cached_miniram(
+        size_type capacity,
+        size_t shard_count = std::max(std::thread::hardware_concurrency(), 1u),
+        size_t magazine_capacity = DEFAULT_MAGAZINE_CAPACITY,
+        size_t initial_alloc_capacity = 16 * 1024
+    );
+
+    /**
+     * allocates a block, small requests are served from the calling thread's magazine if possible
+     * @param size (in elements)
+     * @return allocation (offset, id) or (NO_SPACE, INVALID_INDEX)
+     * @details small blocks are rounded up to their size class
+     */
+    [[nodiscard]] alloc_type allocate(size_type size);
+
+    /**
+     * frees an allocation, may be called from any thread
+     * @param allocation to free
+     * @param size the allocation was requested with
+     */
+    void free(alloc_type allocation, size_type size);
+
+    /**
+     * returns the calling thread's cached blocks to the ram
+     */
+    void flush();
+
+    /**
+     * returns the cached blocks of all threads to the ram
+     * @note must not run concurrently with other calls
+     */
+    void flush_all();
+
+    /**
+     * queries an allocation's size
+     * @param allocation to check
+     * @return size in elements, small blocks report their size class
+     */
+    [[nodiscard]] size_type size_of(alloc_type allocation) const { return _ram.size_of(allocation); }
+
+    /**
+     * flushes all caches and defragments the ram, see @ref basic_sharded_miniram::defragment()
+     * @note must not run concurrently with other calls
+     */
+    [[nodiscard]] defrag_type defragment();
+
+    /**
+     * drops all caches and clears the ram to no allocations
+     * @note must not run concurrently with other calls
+     */
+    void clear();
+
+private:
+    [[nodiscard]] thread_cache& localCache();
+    void flushCache(thread_cache& cache);
+
+    ram_type _ram;
+    size_t _magazineCapacity;
+
+    dev::thread_caches<thread_cache> _caches{};
+
+public:
+    /**
+     * amount of elements in ram
+     */
+    [[nodiscard]] size_type capacity() const { return _ram.capacity(); }
+    /**
+     * max cached blocks per thread and size class
+     */
+    [[nodiscard]] size_t magazine_capacity() const { return _magazineCapacity; }
+    /**
+     * amount of unallocated elements left in ram, cached blocks count as allocated
+     * @note snapshot, may be outdated immediately in threaded environments
+     */
+    [[nodiscard]] size_type remaining() const { return _ram.remaining(); }
+    /**
+     * amount of allocated elements in ram, cached blocks count as allocated
+     * @note snapshot, may be outdated immediately in threaded environments
+     */
+    [[nodiscard]] size_type allocated() const { return _ram.allocated(); }
+    /**
+     * max allocatable block size (in elements)
+     * @note snapshot, may be outdated immediately in threaded environments
+     */
+    [[nodiscard]] size_type max_alloc() const { return _ram.max_alloc(); }
+
+    basic_cached_miniram(basic_cached_miniram const& other) = delete;
+    basic_cached_miniram(basic_cached_miniram&& other) = delete;
+    basic_cached_miniram& operator=(basic_cached_miniram const& other) = delete;
+    basic_cached_miniram& operator=(basic_cached_miniram&& other) = delete;
+};
+
+using cached_miniram32 = basic_cached_miniram<uint32_t, uint32_t>;
+using cached_miniram64 = basic_cached_miniram<uint64_t, uint32_t>;
+using cached_miniram = basic_cached_miniram<size_t, uint32_t>;
+
+}
+
+namespace cth::dt {
+
+template<uint SizeType, uint IndexType>
+basic_cached_miniram<SizeType, IndexType>::basic_cached_miniram(
+    size_type capacity,
+    size_t shard_count,
+    size_t magazine_capacity,
+    size_t initial_alloc_capacity
+) : _ram{capacity, shard_count, initial_alloc_capacity},
+    _magazineCapacity{std::max<size_t>(magazine_capacity, 2)} {}
+
+template<uint SizeType, uint IndexType>
+auto basic_cached_miniram<SizeType, IndexType>::allocate(size_type size) -> alloc_type {
+    if(size == 0 || size > MAX_CACHED_SIZE)
+        return _ram.allocate(size);
+
+    auto& magazine = localCache().magazines[classIndex(size)];
+    if(!magazine.empty()) {
+        auto const alloc = magazine.back();
+        magazine.pop_back();
+        return alloc;
+    }
+
+    return _ram.allocate(classSize(size));
+}
+
+template<uint SizeType, uint IndexType>
+void basic_cached_miniram<SizeType, IndexType>::free(alloc_type allocation, size_type size) {
+    if(size == 0 || size > MAX_CACHED_SIZE) {
+        _ram.free(allocation);
+        return;
+    }
+
+    auto& magazine = localCache().magazines[classIndex(size)];
+
+    // flush the older half, the recently freed blocks are the hot ones
+    if(magazine.size() == _magazineCapacity) {
+        auto const flushed = _magazineCapacity / 2;
+
+        _ram.free_n(std::span{magazine}.first(flushed));
+        magazine.erase(magazine.begin(), magazine.begin() + static_cast<std::ptrdiff_t>(flushed));
+    }
+
+    magazine.push_back(allocation);
+}
+
+template<uint SizeType, uint IndexType>
+void basic_cached_miniram<SizeType, IndexType>::flush() { flushCache(localCache()); }
+
+template<uint SizeType, uint IndexType>
+void basic_cached_miniram<SizeType, IndexType>::flush_all() {
+    _caches.for_each([this](thread_cache& cache) { flushCache(cache); });
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_cached_miniram<SizeType, IndexType>::defragment() -> defrag_type {
+    flush_all();
+    return _ram.defragment();
+}
+
+template<uint SizeType, uint IndexType>
+void basic_cached_miniram<SizeType, IndexType>::clear() {
+    _caches.for_each([](thread_cache& cache) {
+        for(auto& magazine : cache.magazines)
+            magazine.clear();
+    });
+
+    _ram.clear();
+}
+
+template<uint SizeType, uint IndexType>
+constexpr size_t basic_cached_miniram<SizeType, IndexType>::classIndex(size_type size) {
+    if(size <= EXACT_CLASSES)
+        return size - 1;
+
+    auto const pow2 = std::bit_floor(static_cast<size_type>(size - 1));
+    auto const step = pow2 / CLASSES_PER_POW2;
+    auto const exponent = static_cast<size_t>(std::countr_zero(pow2) - std::countr_zero(EXACT_CLASSES));
+
+    return EXACT_CLASSES + exponent * CLASSES_PER_POW2 + (size - pow2 + step - 1) / step - 1;
+}
+
+template<uint SizeType, uint IndexType>
+constexpr auto basic_cached_miniram<SizeType, IndexType>::classSize(size_type size) -> size_type {
+    if(size <= EXACT_CLASSES)
+        return size;
+
+    auto const step = std::bit_floor(static_cast<size_type>(size - 1)) / CLASSES_PER_POW2;
+    return (size + step - 1) / step * step;
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_cached_miniram<SizeType, IndexType>::localCache() -> thread_cache& {
+    return _caches.local([this](thread_cache& cache) {
+        for(auto& magazine : cache.magazines)
+            magazine.reserve(_magazineCapacity);
+    });
+}
+
+template<uint SizeType, uint IndexType>
+void basic_cached_miniram<SizeType, IndexType>::flushCache(thread_cache& cache) {
+    for(auto& magazine : cache.magazines) {
+        _ram.free_n(magazine);
+        magazine.clear();
+    }
+}
+
+}
@@ -0,0 +1,388 @@
+#pragma once
+#include "cth/constants.hpp"
+#include "cth/data/pool.hpp"
+#include "cth/data/thread_caches.hpp"
+#include "cth/io/log.hpp"
+#include "cth/meta/concepts.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace cth::dt {
+
+/**
+ * thread safe reusable resource pool, per thread caches in front of a lock free global free stack
+ * @details
+ * - acquire / release hit the calling thread's cache, a full cache moves half of it to the global stack
+ *   with a single CAS, an empty one takes a batch with a single CAS
+ * - the global stack links slots by index, its head is tagged to make it ABA safe
+ * - storage grows in doubling chunks, instances never move
+ * - Manipulator::reset runs on the releasing thread outside of any lock, it must be thread safe
+ * - instances cached by exited threads are kept until @ref flush_all()
+ * @tparam T to pool
+ * @tparam Manipulator may implement void reset(T&) to reset released instances
+ */
+template<class T, class Manipulator = basic_pool_manipulator>
+class concurrent_pool {
+    using index_type = uint32_t;
+
+    static constexpr index_type INVALID_INDEX = std::numeric_limits<index_type>::max();
+
+    // head layout: [tag:32][index:32]
+    using head_type = uint64_t;
+
+    struct slot {
+        template<class... CArgs>
+        explicit slot(index_type i, CArgs&&... args) : value(std::forward<CArgs>(args)...), index{i} {}
+
+        // first member, the address of a value is the address of its slot
+        T value;
+        index_type index;
+        std::atomic<index_type> next{INVALID_INDEX};
+        bool acquired = false;
+    };
+
+    // chunk k holds FIRST_CHUNK_SIZE << k slots
+    static constexpr size_t FIRST_CHUNK_SIZE = 64;
+    static constexpr size_t MAX_CHUNKS = 26;
+
+public:
+    static constexpr bool HAS_RESET = pool<T, Manipulator>::HAS_RESET;
+    static constexpr size_t DEFAULT_CACHE_CAPACITY = 32;
+    using value_type = T;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) thread_cache {
+        std::vector<index_type> slots{};
+    };
+
+public:
+    /**
+     * @param cache_capacity max cached instances per thread, >= 2
+     * @param manipulator see @ref pool
+     */
+    explicit concurrent_pool(size_t cache_capacity = DEFAULT_CACHE_CAPACITY, Manipulator manipulator = {});
+    ~concurrent_pool();
+
+    /**
+     * constructs an instance of T in the pool, thread safe
+     * @post capacity increases by one
+     * @param args to construct @ref T with
+     */
+    template<class... CArgs> requires std::constructible_from<T, CArgs...>
+    void emplace(CArgs&&... args) {
+        push(slotAt(construct(std::forward<CArgs>(args)...)));
+    }
+
+    /**
+     * acquires a resource from the pool
+     * @return resource or nullptr if none is left
+     */
+    [[nodiscard]] T* try_acquire();
+
+    /**
+     * acquires a resource from the pool
+     * @pre a resource must be left
+     */
+    [[nodiscard]] T& acquire() {
+        auto* const acquired = try_acquire();
+        CTH_CRITICAL(acquired == nullptr, "pool exhausted") {}
+        return *acquired;
+    }
+
+    /**
+     * acquires a resource as @ref lease, released when the lease is destroyed
+     * @pre a resource must be left
+     */
+    [[nodiscard]] lease<T> acquire_lease() { return lease<T>{acquire(), *this}; }
+
+    /**
+     * acquires a resource or constructs a new one if none is left
+     * @param args to construct @ref T with
+     */
+    template<class... CArgs> requires std::constructible_from<T, CArgs...>
+    [[nodiscard]] T& acquire_or_emplace(CArgs&&... args);
+
+    /**
+     * releases a resource, may be called from any thread
+     * @pre @ref t was acquired and not already released
+     * @post @ref t is reset and can be acquired again
+     */
+    void release(T& t);
+
+    /**
+     * moves the calling thread's cached instances to the global stack
+     */
+    void flush();
+
+    /**
+     * moves the cached instances of all threads to the global stack
+     * @note must not run concurrently with other calls
+     */
+    void flush_all();
+
+    /**
+     * clears all acquires and resets acquired objects
+     * @note must not run concurrently with other calls
+     * @pre calling release on a resource which was acquired before clear is UB
+     */
+    void clear();
+
+private:
+    template<class... CArgs>
+    [[nodiscard]] index_type construct(CArgs&&... args);
+
+    [[nodiscard]] slot& slotAt(index_type index) const;
+    [[nodiscard]] static slot& slotOf(T& t) { return *reinterpret_cast<slot*>(std::addressof(t)); }
+
+    /**
+     * pushes the chain first -> ... -> last with a single CAS
+     */
+    void pushChain(slot& first, slot& last);
+    void push(slot& s) { pushChain(s, s); }
+    /**
+     * pops up to count slots with a single CAS
+     */
+    void popBatch(std::vector<index_type>& out, size_t count);
+
+    void flushCache(thread_cache& cache, size_t count);
+
+    [[nodiscard]] thread_cache& localCache();
+
+    [[nodiscard]] static constexpr head_type packHead(head_type tag, index_type index) {
+        return (tag << 32) | index;
+    }
+    [[nodiscard]] static constexpr index_type indexOf(head_type head) {
+        return static_cast<index_type>(head);
+    }
+    [[nodiscard]] static constexpr head_type tagOf(head_type head) { return head >> 32; }
+
+    Manipulator _manipulator;
+    size_t _cacheCapacity;
+
+    std::mutex _storageMutex{};
+    std::array<std::atomic<slot*>, MAX_CHUNKS> _chunks{};
+    std::atomic<size_t> _size{};
+
+    alignas(CACHE_LINE_SIZE) std::atomic<head_type> _head{packHead(0, INVALID_INDEX)};
+
+    alignas(CACHE_LINE_SIZE) dev::thread_caches<thread_cache> _caches{};
+
+public:
+    /**
+     * total number of instances in pool
+     */
+    [[nodiscard]] size_t capacity() const noexcept { return _size.load(std::memory_order::relaxed); }
+    /**
+     * max cached instances per thread
+     */
+    [[nodiscard]] size_t cache_capacity() const noexcept { return _cacheCapacity; }
+
+    concurrent_pool(concurrent_pool const& other) = delete;
+    concurrent_pool(concurrent_pool&& other) = delete;
+    concurrent_pool& operator=(concurrent_pool const& other) = delete;
+    concurrent_pool& operator=(concurrent_pool&& other) = delete;
+};
+
+}
+
+namespace cth::dt {
+
+template<class T, class Manipulator>
+concurrent_pool<T, Manipulator>::concurrent_pool(size_t cache_capacity, Manipulator manipulator) :
+    _manipulator{std::move(manipulator)},
+    _cacheCapacity{std::max<size_t>(cache_capacity, 2)} {}
+
+template<class T, class Manipulator>
+concurrent_pool<T, Manipulator>::~concurrent_pool() {
+    auto const size = _size.load(std::memory_order::relaxed);
+
+    for(size_t i = 0; i < size; ++i)
+        slotAt(static_cast<index_type>(i)).~slot();
+
+    for(size_t k = 0; k < MAX_CHUNKS; ++k)
+        if(auto* const chunk = _chunks[k].load(std::memory_order::relaxed))
+            ::operator delete(chunk, std::align_val_t{alignof(slot)});
+}
+
+template<class T, class Manipulator>
+auto concurrent_pool<T, Manipulator>::try_acquire() -> T* {
+    auto& cache = localCache();
+
+    if(cache.slots.empty()) {
+        popBatch(cache.slots, _cacheCapacity / 2);
+        if(cache.slots.empty())
+            return nullptr;
+    }
+
+    auto& acquired = slotAt(cache.slots.back());
+    cache.slots.pop_back();
+
+    acquired.acquired = true;
+    return std::addressof(acquired.value);
+}
+
+template<class T, class Manipulator>
+template<class... CArgs> requires std::constructible_from<T, CArgs...>
+T& concurrent_pool<T, Manipulator>::acquire_or_emplace(CArgs&&... args) {
+    if(auto* const acquired = try_acquire())
+        return *acquired;
+
+    auto& created = slotAt(construct(std::forward<CArgs>(args)...));
+    created.acquired = true;
+    return created.value;
+}
+
+template<class T, class Manipulator>
+void concurrent_pool<T, Manipulator>::release(T& t) {
+    auto& released = slotOf(t);
+    CTH_CRITICAL(!released.acquired, "a resource must not be released twice") {}
+
+    if constexpr(HAS_RESET)
+        _manipulator.reset(t);
+
+    released.acquired = false;
+
+    auto& cache = localCache();
+    if(cache.slots.size() == _cacheCapacity)
+        flushCache(cache, _cacheCapacity / 2);
+
+    cache.slots.push_back(released.index);
+}
+
+template<class T, class Manipulator>
+void concurrent_pool<T, Manipulator>::flush() {
+    auto& cache = localCache();
+    flushCache(cache, cache.slots.size());
+}
+
+template<class T, class Manipulator>
+void concurrent_pool<T, Manipulator>::flush_all() {
+    _caches.for_each([this](thread_cache& cache) { flushCache(cache, cache.slots.size()); });
+}
+
+template<class T, class Manipulator>
+void concurrent_pool<T, Manipulator>::clear() {
+    _caches.for_each([](thread_cache& cache) { cache.slots.clear(); });
+
+    _head.store(packHead(tagOf(_head.load(std::memory_order::relaxed)) + 1, INVALID_INDEX));
+
+    auto const size = _size.load(std::memory_order::relaxed);
+    for(size_t i = 0; i < size; ++i) {
+        auto& stored = slotAt(static_cast<index_type>(i));
+
+        if constexpr(HAS_RESET)
+            if(stored.acquired)
+                _manipulator.reset(stored.value);
+
+        stored.acquired = false;
+        push(stored);
+    }
+}
+
+template<class T, class Manipulator>
+template<class... CArgs>
+auto concurrent_pool<T, Manipulator>::construct(CArgs&&... args) -> index_type {
+    std::scoped_lock lock{_storageMutex};
+
+    auto const index = static_cast<index_type>(_size.load(std::memory_order::relaxed));
+    CTH_CRITICAL(index == INVALID_INDEX, "pool index space exhausted") {}
+
+    auto const chunk = static_cast<size_t>(std::bit_width(index / FIRST_CHUNK_SIZE + 1) - 1);
+    CTH_CRITICAL(chunk >= MAX_CHUNKS, "pool chunk table exhausted") {}
+
+    if(_chunks[chunk].load(std::memory_order::relaxed) == nullptr) {
+        auto* const storage =
+            ::operator new(sizeof(slot) * (FIRST_CHUNK_SIZE << chunk), std::align_val_t{alignof(slot)});
+        _chunks[chunk].store(static_cast<slot*>(storage), std::memory_order::release);
+    }
+
+    ::new(static_cast<void*>(&slotAt(index))) slot{index, std::forward<CArgs>(args)...};
+
+    // publishes the slot to capacity() readers, the stack publishes it to acquirers
+    _size.store(index + size_t{1}, std::memory_order::release);
+    return index;
+}
+
+template<class T, class Manipulator>
+auto concurrent_pool<T, Manipulator>::slotAt(index_type index) const -> slot& {
+    auto const chunk = static_cast<size_t>(std::bit_width(index / FIRST_CHUNK_SIZE + 1) - 1);
+    auto const chunkBegin = FIRST_CHUNK_SIZE * ((size_t{1} << chunk) - 1);
+
+    return _chunks[chunk].load(std::memory_order::acquire)[index - chunkBegin];
+}
+
+template<class T, class Manipulator>
+void concurrent_pool<T, Manipulator>::pushChain(slot& first, slot& last) {
+    auto head = _head.load(std::memory_order::relaxed);
+
+    do
+        last.next.store(indexOf(head), std::memory_order::relaxed);
+    while(!_head.compare_exchange_weak(
+        head,
+        packHead(tagOf(head) + 1, first.index),
+        std::memory_order::release,
+        std::memory_order::relaxed
+    ));
+}
+
+template<class T, class Manipulator>
+void concurrent_pool<T, Manipulator>::popBatch(std::vector<index_type>& out, size_t count) {
+    auto const begin = out.size();
+    auto head = _head.load(std::memory_order::acquire);
+
+    while(true) {
+        out.resize(begin);
+
+        // the walk may read links that are being rewritten, the tag makes the CAS fail then
+        auto index = indexOf(head);
+        while(index != INVALID_INDEX && out.size() - begin < count) {
+            out.push_back(index);
+            index = slotAt(index).next.load(std::memory_order::relaxed);
+        }
+
+        if(out.size() == begin)
+            return;
+
+        if(_head.compare_exchange_weak(
+               head,
+               packHead(tagOf(head) + 1, index),
+               std::memory_order::acquire,
+               std::memory_order::acquire
+           ))
+            return;
+    }
+}
+
+template<class T, class Manipulator>
+void concurrent_pool<T, Manipulator>::flushCache(thread_cache& cache, size_t count) {
+    if(count == 0)
+        return;
+
+    // the older half, recently released instances are the hot ones
+    std::span const flushed{cache.slots.data(), count};
+
+    for(size_t i = 0; i + 1 < flushed.size(); ++i)
+        slotAt(flushed[i]).next.store(flushed[i + 1], std::memory_order::relaxed);
+
+    pushChain(slotAt(flushed.front()), slotAt(flushed.back()));
+
+    cache.slots.erase(cache.slots.begin(), cache.slots.begin() + static_cast<std::ptrdiff_t>(count));
+}
+
+template<class T, class Manipulator>
+auto concurrent_pool<T, Manipulator>::localCache() -> thread_cache& {
+    return _caches.local([this](thread_cache& cache) { cache.slots.reserve(_cacheCapacity); });
+}
+
+}
@@ -7,14 +7,14 @@
 namespace cth::dt {
 
 // Float conversion helper functions
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::highest_bit(size_type number) -> size_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::highest_bit(size_type number) -> size_type {
     constexpr size_type bits = sizeof(size_type) * 8;
     return bits - 1 - std::countl_zero(number);
 }
 
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::ceil_to_float(size_type size) -> size_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::ceil_to_float(size_type size) -> size_type {
     size_type exp = 0;
     size_type mantissa = 0;
 
@@ -35,8 +35,8 @@ constexpr auto basic_miniram<SizeType, IndexType>::ceil_to_float(size_type size)
     return (exp << MANTISSA_BITS) + mantissa;
 }
 
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::floor_to_float(size_type size) -> size_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::floor_to_float(size_type size) -> size_type {
     if(size < MANTISSA_VALUE)
         return size;
 
@@ -47,8 +47,8 @@ constexpr auto basic_miniram<SizeType, IndexType>::floor_to_float(size_type size
     return (exp << MANTISSA_BITS) | mantissa;
 }
 
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::to_uint(size_type float_value) -> size_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::to_uint(size_type float_value) -> size_type {
     if(float_value < MANTISSA_VALUE)
         return float_value;
 
@@ -58,28 +58,37 @@ constexpr auto basic_miniram<SizeType, IndexType>::to_uint(size_type float_value
 }
 
 // Constructor
-template<uint SizeType, uint IndexType> constexpr basic_miniram<SizeType, IndexType>::basic_miniram(
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr basic_miniram<SizeType, IndexType, Config>::basic_miniram(
     size_type capacity,
     size_t initial_alloc_capacity
 ) : _capacity(capacity),
     _maxAllocs(initial_alloc_capacity) { clear(); }
 
 // Clear
-template<uint SizeType, uint IndexType>
-constexpr void basic_miniram<SizeType, IndexType>::clear() {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::clear() {
     defragmentReset();
 
+    // drops the used flags of the old allocations, generations are kept so their handles stay stale
+    auto const nodeCount = nodes();
+    _nodes.resize(0);
+    _nodes.resize(nodeCount);
+
+    // the stack below the old pointer holds stale (possibly duplicate) ids, every node is free again
     _freeStackPtr = 0;
+    std::iota(_freeNodes.begin(), _freeNodes.end(), index_type{0});
 
     auto const allocCapacity = std::exchange(_maxAllocs, size_t{0});
     reserve_allocations(allocCapacity);
 
-    insertNode(capacity(), 0);
+    _headNode = insertNode(capacity(), 0);
+    _tailNode = _headNode;
 }
 
 // Insert Node
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::insertNode(
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::insertNode(
     size_type size,
     size_type data_offset
 ) -> index_type {
@@ -107,9 +116,9 @@ constexpr auto basic_miniram<SizeType, IndexType>::insertNode(
     return nodeIndex;
 }
 
-// Remove Node
-template<uint SizeType, uint IndexType>
-constexpr void basic_miniram<SizeType, IndexType>::removeNode(index_type node_index) {
+// Unlink Node
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::unlinkNode(index_type node_index) {
     auto const& node = _nodes[node_index];
 
     if(node.binListPrev != INVALID_INDEX) {
@@ -135,20 +144,42 @@ constexpr void basic_miniram<SizeType, IndexType>::removeNode(index_type node_in
                 _usedBinsTop &= ~(top_bin_mask_t{1} << topBinIndex);
         }
     }
+}
 
+// Remove Node
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::removeNode(index_type node_index) {
+    unlinkNode(node_index);
     freeNode(node_index);
 }
 
+// Link Tail
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::linkTail(
+    index_type node_index,
+    index_type prev_node
+) {
+    _nodes[node_index].neighborPrev = prev_node;
+    _nodes[node_index].neighborNext = INVALID_INDEX;
+
+    if(prev_node != INVALID_INDEX)
+        _nodes[prev_node].neighborNext = node_index;
+    else
+        _headNode = node_index;
+
+    _tailNode = node_index;
+}
+
 // New Node
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::newNode(size_type size) -> index_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::newNode(size_type size) -> index_type {
     _freeStorage += size;
     return popFreeNode();
 }
 
 // Free Node
-template<uint SizeType, uint IndexType>
-constexpr void basic_miniram<SizeType, IndexType>::freeNode(index_type node_index) {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::freeNode(index_type node_index) {
     CTH_CRITICAL(node_index >= nodes(), "invalid node index") {}
 
     _freeStorage -= _nodes[node_index].dataSize;
@@ -157,20 +188,26 @@ constexpr void basic_miniram<SizeType, IndexType>::freeNode(index_type node_inde
 }
 
 // Defragment
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::defragment(size_type new_size) -> defrag_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::defragment(size_type new_size) -> defrag_type {
+    [[maybe_unused]] auto const start = statsNow();
+
     defrag_type report{};
 
     std::vector<index_type> usedNodes{};
     usedNodes.reserve(allocated());
 
-    _freeStackPtr = 0;
-    for(size_t i = 0; i < nodes(); ++i) {
-        if(_nodes[i].used)
-            usedNodes.push_back(static_cast<index_type>(i));
-        else
-            _freeNodes[_freeStackPtr++] = static_cast<index_type>(i);
-    }
+    // free space is rebuilt from up to two nodes (main block + sliver)
+    if(remaining_allocs() < 2)
+        reserve_nodes(std::max(nodes() * ALLOC_GROW_FACTOR, _freeStackPtr + 2));
+
+    // free node ids occupy the stack above the pointer
+    size_t freeSlot = nodes();
+    _nodes.visit(
+        [&](size_t i) { usedNodes.push_back(static_cast<index_type>(i)); },
+        [&](size_t i) { _freeNodes[--freeSlot] = static_cast<index_type>(i); }
+    );
+    _freeStackPtr = freeSlot;
 
     size_type compactedOffset = 0;
     index_type lastUsedNode = INVALID_INDEX;
@@ -190,25 +227,334 @@ constexpr auto basic_miniram<SizeType, IndexType>::defragment(size_type new_size
 
     // Clear bin metadata and rebuild free space
     defragmentReset();
+    if(!usedNodes.empty())
+        _headNode = usedNodes.front();
+    _tailNode = lastUsedNode;
+
     if(_capacity > compactedOffset)
         reconstructFreeSpace(compactedOffset, lastUsedNode);
 
+    recordDefragment(start);
+
     return report;
 }
 
+// Defragment Step
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::defragment_step(
+    size_type max_moved
+) -> defrag_step_type {
+    [[maybe_unused]] auto const start = statsNow();
+
+    defrag_step_type step{};
+
+    // resume in front of the cursor (the next allocation to move) or start a new pass
+    auto nodeId = _headNode;
+    if(_defragCursor != INVALID_INDEX) {
+        auto const prevNeighbor = _nodes[_defragCursor].neighborPrev;
+        nodeId = prevNeighbor != INVALID_INDEX ? prevNeighbor : _defragCursor;
+    }
+
+    while(nodeId != INVALID_INDEX) {
+        auto const& node = _nodes[nodeId];
+        auto const nextNodeId = node.neighborNext;
+
+        if(node.used || nextNodeId == INVALID_INDEX) {
+            nodeId = nextNodeId;
+            continue;
+        }
+
+        if(!_nodes[nextNodeId].used) {
+            nodeId = mergeFreeNodes(nodeId, nextNodeId);
+            continue;
+        }
+
+        auto const moveSize = _nodes[nextNodeId].dataSize;
+        if(step.moved > 0 && (moveSize > max_moved || step.moved > max_moved - moveSize)) {
+            _defragCursor = nextNodeId;
+            recordDefragment(start);
+            return step;
+        }
+
+        // hole keeps its size (and bin), only swaps places with the used node
+        swapWithHole(nodeId, nextNodeId, step.report);
+        step.moved += moveSize;
+    }
+
+    _defragCursor = INVALID_INDEX;
+    step.complete = true;
+
+    recordDefragment(start);
+
+    return step;
+}
+
+// Swap With Hole
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::swapWithHole(
+    index_type hole_node,
+    index_type used_node,
+    defrag_type& report
+) {
+    auto&& hole = _nodes[hole_node];
+    auto&& used = _nodes[used_node];
+
+    auto const oldOffset = used.dataOffset;
+    auto const newOffset = hole.dataOffset;
+    auto const size = used.dataSize;
+
+    report.updatedAllocs.emplace_back(newOffset, encodeId(used_node));
+
+    if(size > 0) {
+        bool const contiguous = !report.moves.empty()
+            && report.moves.back().srcOffset + report.moves.back().size == oldOffset
+            && report.moves.back().dstOffset + report.moves.back().size == newOffset;
+
+        if(contiguous)
+            report.moves.back().size += size;
+        else
+            report.moves.emplace_back(oldOffset, newOffset, size);
+    }
+
+    used.dataOffset = newOffset;
+    hole.dataOffset = newOffset + size;
+
+    // [prev][hole][used][next] -> [prev][used][hole][next]
+    auto const prevNeighbor = hole.neighborPrev;
+    auto const nextNeighbor = used.neighborNext;
+
+    used.neighborPrev = prevNeighbor;
+    used.neighborNext = hole_node;
+    hole.neighborPrev = used_node;
+    hole.neighborNext = nextNeighbor;
+
+    if(nextNeighbor != INVALID_INDEX)
+        _nodes[nextNeighbor].neighborPrev = hole_node;
+    else
+        _tailNode = hole_node;
+
+    if(prevNeighbor != INVALID_INDEX)
+        _nodes[prevNeighbor].neighborNext = used_node;
+    else
+        _headNode = used_node;
+}
+
+// Merge Free Nodes
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::mergeFreeNodes(
+    index_type left_node,
+    index_type right_node
+) -> index_type {
+    auto const offset = _nodes[left_node].dataOffset;
+    auto const size = _nodes[left_node].dataSize + _nodes[right_node].dataSize;
+    auto const prevNeighbor = _nodes[left_node].neighborPrev;
+    auto const nextNeighbor = _nodes[right_node].neighborNext;
+
+    removeNode(left_node);
+    removeNode(right_node);
+
+    auto const combinedNodeIndex = insertNode(size, offset);
+    auto&& combinedNode = _nodes[combinedNodeIndex];
+
+    combinedNode.neighborPrev = prevNeighbor;
+    combinedNode.neighborNext = nextNeighbor;
+
+    if(nextNeighbor != INVALID_INDEX)
+        _nodes[nextNeighbor].neighborPrev = combinedNodeIndex;
+    else
+        _tailNode = combinedNodeIndex;
+
+    if(prevNeighbor != INVALID_INDEX)
+        _nodes[prevNeighbor].neighborNext = combinedNodeIndex;
+    else
+        _headNode = combinedNodeIndex;
+
+    return combinedNodeIndex;
+}
+
+// Resize In Place
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr bool basic_miniram<SizeType, IndexType, Config>::resize_in_place(size_type new_capacity) {
+    if(new_capacity >= capacity()) {
+        auto const growth = new_capacity - capacity();
+        if(growth == 0)
+            return true;
+
+        if(_tailNode != INVALID_INDEX && !_nodes[_tailNode].used) {
+            // the grown tail changes its bin
+            auto const tailNodeId = _tailNode;
+            auto const offset = _nodes[tailNodeId].dataOffset;
+            auto const size = _nodes[tailNodeId].dataSize + growth;
+            auto const prevNeighbor = _nodes[tailNodeId].neighborPrev;
+
+            removeNode(tailNodeId);
+            linkTail(insertNode(size, offset), prevNeighbor);
+        } else {
+            if(remaining_allocs() == 0)
+                reserve_allocations();
+
+            linkTail(insertNode(growth, capacity()), _tailNode);
+        }
+
+        _capacity = new_capacity;
+        return true;
+    }
+
+    // the cut off range must be covered by free tail nodes
+    auto nodeId = _tailNode;
+    while(nodeId != INVALID_INDEX && !_nodes[nodeId].used && _nodes[nodeId].dataOffset > new_capacity)
+        nodeId = _nodes[nodeId].neighborPrev;
+
+    if(nodeId != INVALID_INDEX && _nodes[nodeId].used
+        && _nodes[nodeId].dataOffset + _nodes[nodeId].dataSize > new_capacity)
+        return false;
+
+    while(_tailNode != INVALID_INDEX
+        && _nodes[_tailNode].dataOffset + _nodes[_tailNode].dataSize > new_capacity) {
+        auto const tailNodeId = _tailNode;
+        auto const offset = _nodes[tailNodeId].dataOffset;
+        auto const prevNeighbor = _nodes[tailNodeId].neighborPrev;
+
+        removeNode(tailNodeId);
+
+        if(offset < new_capacity) {
+            linkTail(insertNode(new_capacity - offset, offset), prevNeighbor);
+            break;
+        }
+
+        _tailNode = prevNeighbor;
+        if(prevNeighbor != INVALID_INDEX)
+            _nodes[prevNeighbor].neighborNext = INVALID_INDEX;
+        else
+            _headNode = INVALID_INDEX;
+    }
+
+    _capacity = new_capacity;
+    return true;
+}
+
 // Allocate
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::allocate(size_type size) -> alloc_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::allocate(size_type size) -> alloc_type {
     if(size > remaining())
-        return {.offset = NO_SPACE, .id = INVALID_INDEX};
+        return failedAlloc();
 
     if(remaining_allocs() == 0)
         reserve_allocations();
 
-    auto const minBinId = ceil_to_float(size);
+    return allocateReserved(size);
+}
+
+// Allocate Aligned
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::allocate(
+    size_type size,
+    size_type alignment
+) -> alloc_type {
+    CTH_CRITICAL(!std::has_single_bit(alignment), "alignment must be a power of two") {}
+
+    if(alignment == 1)
+        return allocate(size);
+
+    if(size > remaining())
+        return failedAlloc();
+
+    // padding node + remainder node
+    if(remaining_allocs() < 2)
+        reserve_nodes(std::max(nodes() * ALLOC_GROW_FACTOR, _freeStackPtr + 2));
+
+    auto const nodeId = findAlignedNode(size, alignment);
+    if(nodeId == INVALID_INDEX)
+        return failedAlloc();
+
+    unlinkNode(nodeId);
+
+    auto&& node = _nodes[nodeId];
+    auto const offset = node.dataOffset;
+    auto const padding = ((offset + alignment - 1) & ~(alignment - 1)) - offset;
+
+    if(padding > 0) {
+        // [padding][node], the padding goes back to the bins
+        auto const prevNeighbor = node.neighborPrev;
+
+        node.dataOffset += padding;
+        node.dataSize -= padding;
+        _freeStorage -= padding;
+
+        auto const paddingNodeId = insertNode(padding, offset);
+        auto&& paddingNode = _nodes[paddingNodeId];
+
+        paddingNode.neighborPrev = prevNeighbor;
+        paddingNode.neighborNext = nodeId;
+        _nodes[nodeId].neighborPrev = paddingNodeId;
 
-    auto const minTopBinId = minBinId >> TOP_BINS_INDEX_SHIFT;
-    auto const minLeafBinId = minBinId & LEAF_BINS_INDEX_MASK;
+        if(prevNeighbor != INVALID_INDEX)
+            _nodes[prevNeighbor].neighborNext = paddingNodeId;
+        else
+            _headNode = paddingNodeId;
+    }
+
+    claimNode(nodeId, size);
+
+    return allocOf(nodeId);
+}
+
+// Allocate N
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::allocate_n(
+    std::span<size_type const> sizes
+) -> std::vector<alloc_type> {
+    std::vector<alloc_type> allocations{};
+    allocations.reserve(sizes.size());
+
+    // every allocation consumes at most one node (the remainder)
+    if(remaining_allocs() < sizes.size())
+        reserve_nodes(std::max(nodes() * ALLOC_GROW_FACTOR, _freeStackPtr + sizes.size()));
+
+    for(auto const size : sizes) {
+        if(size > remaining())
+            allocations.push_back(failedAlloc());
+        else
+            allocations.push_back(allocateReserved(size));
+    }
+
+    return allocations;
+}
+
+// Allocate Reserved
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::allocateReserved(size_type size) -> alloc_type {
+    if constexpr(PLACEMENT != MiniPlacement::GOOD_FIT) {
+        auto const nodeId = findPlacedNode(size);
+        if(nodeId == INVALID_INDEX)
+            return failedAlloc();
+
+        unlinkNode(nodeId);
+        claimNode(nodeId, size);
+
+        return allocOf(nodeId);
+    }
+
+    auto const binIndex = findUsedBin(ceil_to_float(size));
+
+    if(binIndex == static_cast<size_t>(-1))
+        return failedAlloc();
+
+    auto const topBinIndex = binIndex >> TOP_BINS_INDEX_SHIFT;
+    auto const leafBinIndex = binIndex & LEAF_BINS_INDEX_MASK;
+
+    auto const nodeId = _binIndices[binIndex];
+
+    sliceTopBinNode(size, binIndex, topBinIndex, leafBinIndex);
+
+    return allocOf(nodeId);
+}
+
+// Find Used Bin
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::findUsedBin(size_t min_bin_id) const -> size_t {
+    auto const minTopBinId = min_bin_id >> TOP_BINS_INDEX_SHIFT;
+    auto const minLeafBinId = min_bin_id & LEAF_BINS_INDEX_MASK;
 
     size_t topBinIndex = minTopBinId;
     size_t leafBinIndex = static_cast<size_t>(-1);
@@ -220,23 +566,99 @@ constexpr auto basic_miniram<SizeType, IndexType>::allocate(size_type size) -> a
         topBinIndex = findLowestBitAfter(_usedBinsTop, minTopBinId + 1);
 
         if(topBinIndex == static_cast<size_t>(-1))
-            return {.offset = NO_SPACE, .id = INVALID_INDEX};
+            return static_cast<size_t>(-1);
 
         leafBinIndex = std::countr_zero(_usedBins[topBinIndex]);
     }
 
-    auto const binIndex = (topBinIndex << TOP_BINS_INDEX_SHIFT) | leafBinIndex;
+    return (topBinIndex << TOP_BINS_INDEX_SHIFT) | leafBinIndex;
+}
 
-    auto const nodeId = _binIndices[binIndex];
+// Find Placed Node
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::findPlacedNode(
+    size_type size
+) const -> index_type {
+    auto const minBinId = ceil_to_float(size);
 
-    sliceTopBinNode(size, binIndex, topBinIndex, leafBinIndex);
+    if constexpr(PLACEMENT == MiniPlacement::BEST_FIT) {
+        // the floor bin holds sizes in [to_uint(bin), to_uint(bin + 1)), the bigger ones fit
+        auto const floorBinId = floor_to_float(size);
+
+        if(floorBinId != minBinId)
+            if(auto const nodeId = findInBin(floorBinId, size); nodeId != INVALID_INDEX)
+                return nodeId;
+    }
 
-    return {.offset = _nodes[nodeId].dataOffset, .id = nodeId};
+    auto const binId = findUsedBin(minBinId);
+    if(binId == static_cast<size_t>(-1))
+        return INVALID_INDEX;
+
+    return findInBin(binId, size);
+}
+
+// Find In Bin
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::findInBin(
+    size_t bin_id,
+    size_type size
+) const -> index_type {
+    index_type bestId = INVALID_INDEX;
+    size_type bestKey = NO_SPACE;
+
+    for(auto nodeId = _binIndices[bin_id]; nodeId != INVALID_INDEX; nodeId = _nodes[nodeId].binListNext) {
+        auto const& node = _nodes[nodeId];
+        if(node.dataSize < size)
+            continue;
+
+        auto const key = PLACEMENT == MiniPlacement::BEST_FIT ? node.dataSize : node.dataOffset;
+        if(bestId != INVALID_INDEX && key >= bestKey)
+            continue;
+
+        bestId = nodeId;
+        bestKey = key;
+
+        if(PLACEMENT == MiniPlacement::BEST_FIT && node.dataSize == size)
+            break;
+    }
+
+    return bestId;
+}
+
+// Find Aligned Node
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::findAlignedNode(
+    size_type size,
+    size_type alignment
+) const -> index_type {
+    // every node of at least size + alignment - 1 fits, smaller ones only if their offset lines up
+    auto const fitSize = size > NO_SPACE - (alignment - 1) ? NO_SPACE : size + (alignment - 1);
+    auto const fitBinId = static_cast<size_t>(ceil_to_float(fitSize));
+
+    for(auto binId = findUsedBin(ceil_to_float(size)); binId < fitBinId; binId = findUsedBin(binId + 1)) {
+        auto nodeId = _binIndices[binId];
+
+        for(size_t probe = 0; probe < ALIGNED_SEARCH_PROBES && nodeId != INVALID_INDEX; ++probe) {
+            auto const& node = _nodes[nodeId];
+            auto const padding = ((node.dataOffset + alignment - 1) & ~(alignment - 1)) - node.dataOffset;
+
+            if(node.dataSize >= padding && node.dataSize - padding >= size)
+                return nodeId;
+
+            nodeId = node.binListNext;
+        }
+    }
+
+    auto const binId = findUsedBin(fitBinId);
+    if(binId == static_cast<size_t>(-1))
+        return INVALID_INDEX;
+
+    return _binIndices[binId];
 }
 
 // To Disjunct Copies
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::to_disjunct_copies(
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::to_disjunct_copies(
     std::vector<memmove_type> const& moves
 )
     -> std::vector<memmove_type> {
@@ -278,8 +700,8 @@ constexpr auto basic_miniram<SizeType, IndexType>::to_disjunct_copies(
 }
 
 // Reserve Nodes
-template<uint SizeType, uint IndexType>
-constexpr void basic_miniram<SizeType, IndexType>::reserve_nodes(size_t node_capacity) {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::reserve_nodes(size_t node_capacity) {
     if(node_capacity <= nodes())
         return;
 
@@ -288,31 +710,29 @@ constexpr void basic_miniram<SizeType, IndexType>::reserve_nodes(size_t node_cap
     _nodes.resize(node_capacity);
     _freeNodes.resize(node_capacity);
 
+    if constexpr(GENERATIONS) {
+        CTH_CRITICAL(node_capacity > NODE_ID_MASK, "node count exceeds the id bits left by the generation") {}
+        _generations.resize(node_capacity);
+    }
+
     std::iota(_freeNodes.begin() + oldCapacity, _freeNodes.end(), static_cast<index_type>(oldCapacity));
 }
 
 // Slice Top Bin Node
-template<uint SizeType, uint IndexType>
-constexpr void basic_miniram<SizeType, IndexType>::sliceTopBinNode(
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::sliceTopBinNode(
     size_type slice_size,
     size_t bin_id,
     size_t top_bin_id,
     size_t leaf_bin_id
 ) {
     auto const originalNodeId = _binIndices[bin_id];
-    auto& node = _nodes[originalNodeId];
-
-    auto const nodeTotalSize = node.dataSize;
-
-    _freeStorage -= nodeTotalSize;
-
-    node.dataSize = slice_size;
-    node.used = true;
+    auto const nextNodeId = _nodes[originalNodeId].binListNext;
 
-    _binIndices[bin_id] = node.binListNext;
+    _binIndices[bin_id] = nextNodeId;
 
-    if(node.binListNext != INVALID_INDEX)
-        _nodes[node.binListNext].binListPrev = INVALID_INDEX;
+    if(nextNodeId != INVALID_INDEX)
+        _nodes[nextNodeId].binListPrev = INVALID_INDEX;
 
     if(_binIndices[bin_id] == INVALID_INDEX) {
         _usedBins[top_bin_id] &= ~(leaf_bin_mask_t{1} << leaf_bin_id);
@@ -321,30 +741,61 @@ constexpr void basic_miniram<SizeType, IndexType>::sliceTopBinNode(
             _usedBinsTop &= ~(top_bin_mask_t{1} << top_bin_id);
     }
 
+    claimNode(originalNodeId, slice_size);
+}
+
+// Claim Node
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::claimNode(
+    index_type node_index,
+    size_type slice_size
+) {
+    auto&& node = _nodes[node_index];
+
+    auto const nodeTotalSize = node.dataSize;
+
+    _freeStorage -= nodeTotalSize;
+
+    node.dataSize = slice_size;
+    node.used = true;
+
+    // invalidates handles of earlier allocations on this node
+    if constexpr(GENERATIONS)
+        _generations[node_index] = (_generations[node_index] + 1) % GENERATION_COUNT;
+
     auto const reminderSize = nodeTotalSize - slice_size;
     if(reminderSize > 0) {
         auto const newNodeIndex = insertNode(reminderSize, node.dataOffset + slice_size);
-        auto& newNode = _nodes[newNodeIndex];
+        auto&& newNode = _nodes[newNodeIndex];
 
         if(node.neighborNext != INVALID_INDEX)
             _nodes[node.neighborNext].neighborPrev = newNodeIndex;
+        else
+            _tailNode = newNodeIndex;
 
-        newNode.neighborPrev = originalNodeId;
+        newNode.neighborPrev = node_index;
         newNode.neighborNext = node.neighborNext;
 
         node.neighborNext = newNodeIndex;
     }
+
+    if constexpr(STATS)
+        recordAlloc(slice_size, nodeTotalSize);
 }
 
 // Find Lowest Bit After
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::findLowestBitAfter(
-    top_bin_mask_t bit_mask,
+template<uint SizeType, uint IndexType, mini_config Config>
+template<class Mask>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::findLowestBitAfter(
+    Mask bit_mask,
     size_t start_id
 ) -> size_t {
-    auto const maskBefore = (top_bin_mask_t{1} << start_id) - 1;
-    auto const maskAfter = ~maskBefore;
-    auto const bitsAfter = bit_mask & maskAfter;
+    if(start_id >= sizeof(Mask) * 8)
+        return static_cast<size_t>(-1);
+
+    auto const maskBefore = static_cast<Mask>((Mask{1} << start_id) - 1);
+    auto const maskAfter = static_cast<Mask>(~maskBefore);
+    auto const bitsAfter = static_cast<Mask>(bit_mask & maskAfter);
 
     if(bitsAfter == 0)
         return static_cast<size_t>(-1);
@@ -353,50 +804,120 @@ constexpr auto basic_miniram<SizeType, IndexType>::findLowestBitAfter(
 }
 
 // Free
-template<uint SizeType, uint IndexType>
-constexpr void basic_miniram<SizeType, IndexType>::free(alloc_type allocation) {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::free(alloc_type allocation) {
     if(_nodes.empty())
         return;
 
-    auto const nodeId = allocation.id;
-    auto& node = _nodes[nodeId];
+    auto const nodeId = nodeIdOf(allocation);
+    auto const& node = _nodes[nodeId];
 
     CTH_CRITICAL(!node.used, "cannot free an already freed node") {}
 
-    auto offset = node.dataOffset;
-    auto size = node.dataSize;
-    auto prevNeighbor = node.neighborPrev;
-    auto nextNeighbor = node.neighborNext;
+    if(nodeId == _defragCursor)
+        _defragCursor = INVALID_INDEX;
+
+    if constexpr(STATS)
+        ++_stats.frees;
+
+    releaseNodes(nodeId, nodeId, node.dataSize);
+}
+
+// Free N
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::free_n(std::span<alloc_type const> allocations) {
+    if(_nodes.empty() || allocations.empty())
+        return;
+
+    if constexpr(STATS)
+        _stats.frees += allocations.size();
+
+    std::vector<index_type> sortedNodes{};
+    sortedNodes.reserve(allocations.size());
+    for(auto const& allocation : allocations)
+        sortedNodes.push_back(nodeIdOf(allocation));
+
+    std::ranges::sort(
+        sortedNodes,
+        [&](index_type a, index_type b) { return _nodes[a].dataOffset < _nodes[b].dataOffset; }
+    );
+
+    for(size_t i = 0; i < sortedNodes.size();) {
+        auto const firstNodeId = sortedNodes[i];
+        auto&& firstNode = _nodes[firstNodeId];
+
+        CTH_CRITICAL(!firstNode.used, "cannot free an already freed node") {}
+        firstNode.used = false;
+
+        if(firstNodeId == _defragCursor)
+            _defragCursor = INVALID_INDEX;
+
+        auto lastNodeId = firstNodeId;
+        auto size = firstNode.dataSize;
+
+        // absorb directly following allocations of the batch into this run
+        for(++i; i < sortedNodes.size() && _nodes[lastNodeId].neighborNext == sortedNodes[i]; ++i) {
+            auto const nodeId = sortedNodes[i];
+            auto&& node = _nodes[nodeId];
+
+            CTH_CRITICAL(!node.used, "cannot free an already freed node") {}
+            node.used = false;
+
+            if(nodeId == _defragCursor)
+                _defragCursor = INVALID_INDEX;
+
+            size += node.dataSize;
+            lastNodeId = nodeId;
+
+            pushFreeNode() = nodeId;
+        }
+
+        releaseNodes(firstNodeId, lastNodeId, size);
+    }
+}
+
+// Release Nodes
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::releaseNodes(
+    index_type first_node,
+    index_type last_node,
+    size_type size
+) {
+    auto offset = _nodes[first_node].dataOffset;
+    auto prevNeighbor = _nodes[first_node].neighborPrev;
+    auto nextNeighbor = _nodes[last_node].neighborNext;
 
     // Merge with previous free neighbor
     if(prevNeighbor != INVALID_INDEX && !_nodes[prevNeighbor].used) {
-        auto const& prevNode = _nodes[prevNeighbor];
-        CTH_CRITICAL(prevNode.neighborNext != nodeId, "Neighbor chain corrupted: prev->next != current") {}
+        auto const prevNodeId = prevNeighbor;
+        auto const& prevNode = _nodes[prevNodeId];
+        CTH_CRITICAL(prevNode.neighborNext != first_node, "Neighbor chain corrupted: prev->next != current") {}
 
         offset = prevNode.dataOffset;
         size += prevNode.dataSize;
         prevNeighbor = prevNode.neighborPrev;
 
-        removeNode(node.neighborPrev);
+        removeNode(prevNodeId);
     }
 
     // Merge with next free neighbor
     if(nextNeighbor != INVALID_INDEX && !_nodes[nextNeighbor].used) {
-        auto const& nextNode = _nodes[nextNeighbor];
-        CTH_CRITICAL(nextNode.neighborPrev != nodeId, "Neighbor chain corrupted: next->prev != current") {}
+        auto const nextNodeId = nextNeighbor;
+        auto const& nextNode = _nodes[nextNodeId];
+        CTH_CRITICAL(nextNode.neighborPrev != last_node, "Neighbor chain corrupted: next->prev != current") {}
 
         size += nextNode.dataSize;
         nextNeighbor = nextNode.neighborNext;
 
-        removeNode(node.neighborNext);
+        removeNode(nextNodeId);
     }
 
-    // Return current node to free pool
-    pushFreeNode() = nodeId;
+    // Return first node to free pool, reused by the merged node
+    pushFreeNode() = first_node;
 
     // Create merged free node
     auto const combinedNodeIndex = insertNode(size, offset);
-    auto& combinedNode = _nodes[combinedNodeIndex];
+    auto&& combinedNode = _nodes[combinedNodeIndex];
 
     // Reconnect neighbor chain
     combinedNode.neighborPrev = prevNeighbor;
@@ -404,61 +925,114 @@ constexpr void basic_miniram<SizeType, IndexType>::free(alloc_type allocation) {
 
     if(nextNeighbor != INVALID_INDEX)
         _nodes[nextNeighbor].neighborPrev = combinedNodeIndex;
+    else
+        _tailNode = combinedNodeIndex;
 
     if(prevNeighbor != INVALID_INDEX)
         _nodes[prevNeighbor].neighborNext = combinedNodeIndex;
+    else
+        _headNode = combinedNodeIndex;
 }
 
 // Size Of
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::size_of(alloc_type allocation) const -> size_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::size_of(alloc_type allocation) const -> size_type {
     if(allocation.id == INVALID_INDEX || _nodes.empty())
         return 0;
 
-    return _nodes[allocation.id].dataSize;
+    return _nodes[nodeIdOf(allocation)].dataSize;
+}
+
+// Valid
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr bool basic_miniram<SizeType, IndexType, Config>::valid(alloc_type allocation) const {
+    if(allocation.id == INVALID_INDEX)
+        return false;
+
+    auto const nodeId = static_cast<index_type>(allocation.id & NODE_ID_MASK);
+    if(nodeId >= nodes() || !_nodes[nodeId].used)
+        return false;
+
+    if constexpr(GENERATIONS)
+        return _generations[nodeId] == allocation.id >> NODE_ID_BITS;
+
+    return true;
 }
 
 // Max Alloc
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::max_alloc() const -> size_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::max_alloc() const -> size_type {
     if(remaining() == 0)
         return 0;
 
-    size_t const topBinIndex = highest_bit(_usedBinsTop);
-    size_t const leafBinIndex = highest_bit(static_cast<size_type>(_usedBins[topBinIndex]));
+    size_t const topBinIndex = highest_mask_bit(_usedBinsTop);
+    size_t const leafBinIndex = highest_mask_bit(_usedBins[topBinIndex]);
     size_t const finalBinIndex = (topBinIndex << TOP_BINS_INDEX_SHIFT) | leafBinIndex;
 
     return to_uint(static_cast<size_type>(finalBinIndex));
 }
 
 // Defragment Reset
-template<uint SizeType, uint IndexType>
-constexpr void basic_miniram<SizeType, IndexType>::defragmentReset() {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::defragmentReset() {
     _usedBinsTop = 0;
     _usedBins.fill(0);
     _binIndices.fill(INVALID_INDEX);
     _freeStorage = 0;
+
+    _headNode = INVALID_INDEX;
+    _tailNode = INVALID_INDEX;
+    _defragCursor = INVALID_INDEX;
+}
+
+// Alloc Of
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::allocOf(
+    index_type node_index
+) const -> alloc_type {
+    return {.offset = _nodes[node_index].dataOffset, .id = encodeId(node_index)};
+}
+
+// Encode Id
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::encodeId(
+    index_type node_index
+) const -> index_type {
+    if constexpr(GENERATIONS)
+        return static_cast<index_type>((_generations[node_index] << NODE_ID_BITS) | node_index);
+    else
+        return node_index;
+}
+
+// Node Id Of
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::nodeIdOf(
+    alloc_type allocation
+) const -> index_type {
+    CTH_CRITICAL(GENERATIONS && !valid(allocation), "stale or invalid allocation handle") {}
+
+    return static_cast<index_type>(allocation.id & NODE_ID_MASK);
 }
 
 // Pop Free Node
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::popFreeNode() -> index_type {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::popFreeNode() -> index_type {
     CTH_CRITICAL(_freeStackPtr >= nodes(), "free stack already empty") {}
 
     return _freeNodes[_freeStackPtr++];
 }
 
 // Push Free Node
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::pushFreeNode() -> index_type& {
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::pushFreeNode() -> index_type& {
     CTH_CRITICAL(_freeStackPtr == 0, "free stack already full") {}
 
     return _freeNodes[--_freeStackPtr];
 }
 
 // Compact Used Nodes
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::compactUsedNodes(
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::compactUsedNodes(
     std::vector<index_type> const& used_nodes,
     defrag_type& report
 ) -> size_type {
@@ -470,11 +1044,11 @@ constexpr auto basic_miniram<SizeType, IndexType>::compactUsedNodes(
     size_type prevNodeOldOffset = 0;
 
     for(auto const currentNodeID : used_nodes) {
-        auto& node = _nodes[currentNodeID];
+        auto&& node = _nodes[currentNodeID];
         auto const oldOffset = node.dataOffset;
         auto const nodeSize = node.dataSize;
 
-        report.updatedAllocs.emplace_back(compactedOffset, currentNodeID);
+        report.updatedAllocs.emplace_back(compactedOffset, encodeId(currentNodeID));
 
         if(oldOffset != compactedOffset) {
             bool const contiguous =
@@ -505,8 +1079,8 @@ constexpr auto basic_miniram<SizeType, IndexType>::compactUsedNodes(
 }
 
 // Reconstruct Free Space
-template<uint SizeType, uint IndexType>
-constexpr void basic_miniram<SizeType, IndexType>::reconstructFreeSpace(
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::reconstructFreeSpace(
     size_type compacted_offset,
     index_type last_used_node
 ) {
@@ -524,33 +1098,40 @@ constexpr void basic_miniram<SizeType, IndexType>::reconstructFreeSpace(
     // Insert main free block
     if(mainBlockSize > 0) {
         auto const mainNode = insertNode(mainBlockSize, compacted_offset);
-        auto& mainNodeRef = _nodes[mainNode];
+        auto&& mainNodeRef = _nodes[mainNode];
 
         mainNodeRef.used = false;
         mainNodeRef.neighborPrev = previousFreeNode;
 
         if(previousFreeNode != INVALID_INDEX)
             _nodes[previousFreeNode].neighborNext = mainNode;
+        else
+            _headNode = mainNode;
 
         previousFreeNode = mainNode;
+        _tailNode = mainNode;
     }
 
     // Insert sliver free block (if any remainder exists)
     if(sliverSize > 0) {
         auto const sliverNode = insertNode(sliverSize, compacted_offset + mainBlockSize);
-        auto& sliverNodeRef = _nodes[sliverNode];
+        auto&& sliverNodeRef = _nodes[sliverNode];
 
         sliverNodeRef.used = false;
         sliverNodeRef.neighborPrev = previousFreeNode;
 
         if(previousFreeNode != INVALID_INDEX)
             _nodes[previousFreeNode].neighborNext = sliverNode;
+        else
+            _headNode = sliverNode;
+
+        _tailNode = sliverNode;
     }
 }
 
 // Free Regions
-template<uint SizeType, uint IndexType>
-constexpr auto basic_miniram<SizeType, IndexType>::free_regions() const
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::free_regions() const
     -> std::array<regions_type, NUM_LEAF_BINS> {
     std::array<regions_type, NUM_LEAF_BINS> regions{};
 
@@ -568,4 +1149,300 @@ constexpr auto basic_miniram<SizeType, IndexType>::free_regions() const
     return regions;
 }
 
+// Failed Alloc
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::failedAlloc() -> alloc_type {
+    if constexpr(STATS)
+        ++_stats.failedAllocs;
+
+    return {.offset = NO_SPACE, .id = INVALID_INDEX};
+}
+
+// Record Alloc
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::recordAlloc(size_type size, size_type block_size) {
+    auto const sizeClassId = ceil_to_float(size);
+    auto& sizeClass = _stats.sizeClasses[sizeClassId];
+
+    ++_stats.allocs;
+    ++sizeClass.allocs;
+    sizeClass.requested += size;
+    sizeClass.granted += block_size;
+
+    if(floor_to_float(block_size) > sizeClassId)
+        ++_stats.binMisses;
+
+    _stats.peakAllocated = std::max(_stats.peakAllocated, allocated());
+}
+
+// Stats Now
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_miniram<SizeType, IndexType, Config>::statsNow() -> stats_clock::time_point {
+    if constexpr(STATS)
+        if !consteval {
+            return stats_clock::now();
+        }
+
+    return {};
+}
+
+// Record Defragment
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_miniram<SizeType, IndexType, Config>::recordDefragment(
+    [[maybe_unused]] stats_clock::time_point start
+) {
+    if constexpr(STATS) {
+        ++_stats.defragmentations;
+
+        if !consteval {
+            auto const elapsed = stats_clock::now() - start;
+            _stats.defragmentTime += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+        }
+    }
+}
+
+// Snapshot Size
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr size_t basic_miniram<SizeType, IndexType, Config>::snapshotSize(size_t node_count) {
+    return sizeof(snapshot_format) + sizeof(snapshot_state) + sizeof(top_bin_mask_t)
+        + sizeof(std::array<leaf_bin_mask_t, NUM_TOP_BINS>) + sizeof(std::array<index_type, NUM_LEAF_BINS>)
+        + node_storage_t::byte_size(node_count) + node_count * sizeof(index_type)
+        + (GENERATIONS ? node_count * sizeof(index_type) : 0);
+}
+
+// Snapshot
+template<uint SizeType, uint IndexType, mini_config Config>
+void basic_miniram<SizeType, IndexType, Config>::snapshot(std::span<std::byte> blob) const {
+    CTH_CRITICAL(blob.size() < snapshot_size(), "blob too small for the snapshot") {}
+
+    snapshot_state const state{
+        .capacity = _capacity,
+        .freeStorage = _freeStorage,
+        .nodes = nodes(),
+        .freeStackPtr = _freeStackPtr,
+        .headNode = _headNode,
+        .tailNode = _tailNode,
+        .defragCursor = _defragCursor,
+    };
+
+    auto* dst = blob.data();
+    auto const write = [&dst](void const* src, size_t bytes) {
+        std::memcpy(dst, src, bytes);
+        dst += bytes;
+    };
+
+    snapshot_format const format{};
+    write(&format, sizeof(format));
+    write(&state, sizeof(state));
+    write(&_usedBinsTop, sizeof(_usedBinsTop));
+    write(_usedBins.data(), sizeof(_usedBins));
+    write(_binIndices.data(), sizeof(_binIndices));
+
+    _nodes.write(dst);
+    dst += _nodes.byte_size();
+
+    write(_freeNodes.data(), _freeNodes.size() * sizeof(index_type));
+
+    if constexpr(GENERATIONS)
+        write(_generations.data(), _generations.size() * sizeof(index_type));
+}
+
+template<uint SizeType, uint IndexType, mini_config Config>
+std::vector<std::byte> basic_miniram<SizeType, IndexType, Config>::snapshot() const {
+    std::vector<std::byte> blob(snapshot_size());
+    snapshot(blob);
+    return blob;
+}
+
+// Restore
+template<uint SizeType, uint IndexType, mini_config Config>
+auto basic_miniram<SizeType, IndexType, Config>::restore(std::span<std::byte const> blob) -> basic_miniram {
+    snapshot_format format{};
+    snapshot_state state{};
+
+    CTH_STABLE_ERR(blob.size() < sizeof(format) + sizeof(state), "snapshot is truncated") {
+        details->add("size: {}", blob.size());
+        throw details->exception();
+    }
+
+    auto const* src = blob.data();
+    auto const read = [&src](void* dst, size_t bytes) {
+        std::memcpy(dst, src, bytes);
+        src += bytes;
+    };
+
+    read(&format, sizeof(format));
+    read(&state, sizeof(state));
+
+    CTH_STABLE_ERR(format != snapshot_format{}, "snapshot format is incompatible") {
+        details->add("version: {}, layout: {}", format.version, format.layout);
+        details->add("bins per leaf: {}, generation bits: {}", format.binsPerLeaf, format.generationBits);
+        throw details->exception();
+    }
+
+    // every node takes at least one free stack entry, bounding the count keeps snapshotSize from overflowing
+    CTH_STABLE_ERR(
+        state.nodes > blob.size() / sizeof(index_type) || state.nodes > INVALID_INDEX
+            || state.capacity > std::numeric_limits<size_type>::max(),
+        "snapshot is corrupted"
+    ) {
+        details->add("size: {}, nodes: {}, capacity: {}", blob.size(), state.nodes, state.capacity);
+        throw details->exception();
+    }
+
+    auto const nodeCount = static_cast<size_t>(state.nodes);
+
+    CTH_STABLE_ERR(blob.size() < snapshotSize(nodeCount), "snapshot is truncated") {
+        details->add("size: {}, nodes: {}", blob.size(), nodeCount);
+        throw details->exception();
+    }
+
+    basic_miniram ram{static_cast<size_type>(state.capacity), 1};
+
+    read(&ram._usedBinsTop, sizeof(ram._usedBinsTop));
+    read(ram._usedBins.data(), sizeof(ram._usedBins));
+    read(ram._binIndices.data(), sizeof(ram._binIndices));
+
+    CTH_STABLE_ERR(!ram._nodes.read(src, nodeCount), "snapshot is corrupted") {
+        details->add("invalid node used flags");
+        throw details->exception();
+    }
+    src += ram._nodes.byte_size();
+
+    ram._freeNodes.resize(nodeCount);
+    read(ram._freeNodes.data(), nodeCount * sizeof(index_type));
+
+    if constexpr(GENERATIONS) {
+        ram._generations.resize(nodeCount);
+        read(ram._generations.data(), nodeCount * sizeof(index_type));
+    }
+
+    ram._freeStorage = static_cast<size_type>(state.freeStorage);
+    ram._freeStackPtr = static_cast<size_t>(state.freeStackPtr);
+    ram._headNode = static_cast<index_type>(state.headNode);
+    ram._tailNode = static_cast<index_type>(state.tailNode);
+    ram._defragCursor = static_cast<index_type>(state.defragCursor);
+
+    auto const* const corruption = ram.snapshotCorruption();
+    CTH_STABLE_ERR(corruption != nullptr, "snapshot is corrupted") {
+        details->add("{}", corruption);
+        throw details->exception();
+    }
+
+    return ram;
+}
+
+// Snapshot Corruption
+template<uint SizeType, uint IndexType, mini_config Config>
+char const* basic_miniram<SizeType, IndexType, Config>::snapshotCorruption() const {
+    auto const nodeCount = nodes();
+    auto const validIndex = [nodeCount](index_type index) {
+        return index == INVALID_INDEX || static_cast<size_t>(index) < nodeCount;
+    };
+
+    if(_freeStorage > _capacity)
+        return "free storage exceeds the capacity";
+    if(_freeStackPtr > nodeCount)
+        return "free stack pointer out of range";
+    if(!validIndex(_headNode) || !validIndex(_tailNode) || !validIndex(_defragCursor))
+        return "list head out of range";
+
+    for(auto const id : _freeNodes)
+        if(static_cast<size_t>(id) >= nodeCount)
+            return "free stack entry out of range";
+
+    // only live nodes are checked, nodes on the free stack keep stale ranges and links (e.g. after a shrink)
+    std::vector<bool> live(nodeCount);
+    std::vector<bool> freeOnChain(nodeCount);
+    size_t freeNodes = 0;
+    size_t liveNodes = 0;
+
+    // the neighbor chain covers [0, capacity) without gaps, the step bound catches cycles
+    auto prev = INVALID_INDEX;
+    uint64_t offset = 0;
+    for(auto id = _headNode; id != INVALID_INDEX; id = std::as_const(_nodes)[id].neighborNext) {
+        if(++liveNodes > nodeCount)
+            return "neighbor chain has a cycle";
+
+        auto const node = std::as_const(_nodes)[id];
+        if(!validIndex(node.binListPrev) || !validIndex(node.binListNext) || !validIndex(node.neighborNext))
+            return "node link out of range";
+        if(node.neighborPrev != prev)
+            return "neighbor chain links inconsistent";
+        if(node.dataOffset != offset || node.dataSize > _capacity - offset)
+            return "node range out of place";
+
+        live[id] = true;
+        if(!node.used) {
+            freeOnChain[id] = true;
+            ++freeNodes;
+        }
+
+        offset += node.dataSize;
+        prev = id;
+    }
+
+    if(offset != _capacity || prev != _tailNode)
+        return "neighbor chain doesn't cover the capacity";
+    if(liveNodes != _freeStackPtr)
+        return "live nodes don't match the free stack";
+
+    // the stack above the pointer holds every dead node once, the entries below it are stale
+    for(size_t i = _freeStackPtr; i < nodeCount; ++i) {
+        auto const id = _freeNodes[i];
+        if(live[id])
+            return "free stack holds a live or duplicate node";
+        live[id] = true;
+    }
+
+    // every free node is in exactly one bin, the one of its size
+    std::vector<bool> binned(nodeCount);
+    size_t binnedNodes = 0;
+
+    for(size_t bin = 0; bin < NUM_LEAF_BINS; ++bin) {
+        prev = INVALID_INDEX;
+        for(auto id = _binIndices[bin]; id != INVALID_INDEX; id = std::as_const(_nodes)[id].binListNext) {
+            if(!validIndex(id))
+                return "bin list head out of range";
+            if(!freeOnChain[id] || binned[id])
+                return "bin list holds a used or foreign node";
+
+            auto const node = std::as_const(_nodes)[id];
+            if(node.binListPrev != prev || floor_to_float(node.dataSize) != bin)
+                return "bin list links inconsistent";
+
+            binned[id] = true;
+            ++binnedNodes;
+            prev = id;
+        }
+    }
+
+    if(binnedNodes != freeNodes)
+        return "free node missing from the bins";
+
+    // masks of unused bits must be zero, a bin bit is set exactly if its list is not empty
+    if constexpr(NUM_TOP_BINS < sizeof(top_bin_mask_t) * 8)
+        if((_usedBinsTop >> NUM_TOP_BINS) != 0)
+            return "top bin mask out of range";
+
+    for(size_t top = 0; top < NUM_TOP_BINS; ++top) {
+        auto const leafMask = _usedBins[top];
+
+        if constexpr(BINS_PER_LEAF < sizeof(leaf_bin_mask_t) * 8)
+            if((leafMask >> BINS_PER_LEAF) != 0)
+                return "leaf bin mask out of range";
+        if(((_usedBinsTop >> top) & 1) != (leafMask != 0))
+            return "top bin mask inconsistent";
+
+        for(size_t leaf = 0; leaf < BINS_PER_LEAF; ++leaf) {
+            auto const head = _binIndices[top * BINS_PER_LEAF + leaf];
+
+            if(((leafMask >> leaf) & 1) != (head != INVALID_INDEX))
+                return "leaf bin mask inconsistent";
+        }
+    }
+
+    return nullptr;
+}
+
 }
@@ -0,0 +1,248 @@
+#pragma once
+#include "cth/data/miniram.hpp"
+#include "cth/io/log.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace cth::dt {
+
+/**
+ * offset allocator with segregated lifetimes
+ * resident blocks come from the low end of the range, transient blocks from the high end
+ * @details
+ * - resident blocks come from a @ref basic_miniram over the range prefix, the prefix grows / shrinks in place
+ * - transient blocks are bump allocated downwards from the end of the range (double ended stack)
+ * - transient blocks are released together, @ref free_transient() and @ref rewind_transient() are O(1)
+ * - transient churn never fragments the space around resident blocks
+ * @tparam Config of the resident @ref basic_miniram, @ref MiniPlacement::LOWEST_ADDRESS keeps it tighter
+ */
+template<uint SizeType, uint IndexType, mini_config Config = mini_config{}>
+class basic_lifetime_miniram {
+public:
+    using ram_type = basic_miniram<SizeType, IndexType, Config>;
+    using size_type = SizeType;
+    using index_type = IndexType;
+    using alloc_type = typename ram_type::alloc_type;
+    using defrag_type = typename ram_type::defrag_type;
+
+    static constexpr index_type INVALID_INDEX = ram_type::INVALID_INDEX;
+    static constexpr size_type NO_SPACE = ram_type::NO_SPACE;
+
+    /**
+     * constructs
+     * @param capacity of ram (in elements)
+     * @param initial_alloc_capacity of the resident ram (in allocations), >= 1
+     */
+    constexpr explicit basic_lifetime_miniram(size_type capacity, size_t initial_alloc_capacity = 16 * 1024);
+
+    /**
+     * allocates a resident block, may fail
+     * @param size (in elements)
+     * @return allocation (offset, id) or (NO_SPACE, INVALID_INDEX)
+     * @details grows the resident region in place towards the transient blocks if needed
+     */
+    [[nodiscard]] constexpr alloc_type allocate(size_type size);
+
+    /**
+     * allocates an aligned resident block, may fail
+     * @param size (in elements)
+     * @param alignment of the offset (in elements), power of two
+     * @return allocation (offset, id) or (NO_SPACE, INVALID_INDEX)
+     */
+    [[nodiscard]] constexpr alloc_type allocate(size_type size, size_type alignment);
+
+    /**
+     * frees a resident allocation
+     * @param allocation to free
+     */
+    constexpr void free(alloc_type allocation) { _ram.free(allocation); }
+
+    /**
+     * queries a resident allocation's size
+     * @param allocation to check
+     * @return size in elements
+     */
+    [[nodiscard]] constexpr size_type size_of(alloc_type allocation) const {
+        return _ram.size_of(allocation);
+    }
+
+    /**
+     * allocates a transient block, may fail
+     * @param size (in elements)
+     * @param alignment of the offset (in elements), power of two
+     * @return offset or NO_SPACE
+     * @details shrinks the resident region in place if its free tail is in the way
+     */
+    [[nodiscard]] constexpr size_type allocate_transient(size_type size, size_type alignment = 1);
+
+    /**
+     * current position of the transient stack, see @ref rewind_transient()
+     */
+    [[nodiscard]] constexpr size_type transient_marker() const { return _transientBegin; }
+
+    /**
+     * frees all transient blocks allocated after marker was taken, O(1)
+     * @param marker from @ref transient_marker()
+     */
+    constexpr void rewind_transient(size_type marker);
+
+    /**
+     * frees all transient blocks, O(1)
+     */
+    constexpr void free_transient() { _transientBegin = capacity(); }
+
+    /**
+     * defragments the resident blocks (left compaction), see @ref basic_miniram::defragment()
+     * @return defragmentation report, transient blocks don't move
+     */
+    [[nodiscard]] constexpr defrag_type defragment() { return _ram.defragment(); }
+
+    /**
+     * clears the ram to no allocations
+     */
+    constexpr void clear();
+
+private:
+    template<class AllocFn>
+    [[nodiscard]] constexpr alloc_type allocateResident(size_type size, AllocFn&& alloc_fn);
+    [[nodiscard]] constexpr bool growResident(size_type size);
+
+    size_type _capacity;
+    size_type _transientBegin;
+    ram_type _ram;
+
+public:
+    /**
+     * amount of elements in ram
+     */
+    [[nodiscard]] constexpr size_type capacity() const { return _capacity; }
+    /**
+     * size of the resident region (in elements)
+     */
+    [[nodiscard]] constexpr size_type resident_capacity() const { return _ram.capacity(); }
+    /**
+     * amount of elements in resident blocks
+     */
+    [[nodiscard]] constexpr size_type resident_allocated() const { return _ram.allocated(); }
+    /**
+     * amount of elements in transient blocks, including alignment padding
+     */
+    [[nodiscard]] constexpr size_type transient_allocated() const { return capacity() - _transientBegin; }
+    /**
+     * amount of allocated elements in ram
+     */
+    [[nodiscard]] constexpr size_type allocated() const {
+        return resident_allocated() + transient_allocated();
+    }
+    /**
+     * amount of unallocated elements left in ram
+     */
+    [[nodiscard]] constexpr size_type remaining() const { return capacity() - allocated(); }
+    /**
+     * the resident ram, for queries
+     */
+    [[nodiscard]] constexpr ram_type const& resident() const { return _ram; }
+};
+
+using lifetime_miniram32 = basic_lifetime_miniram<uint32_t, uint32_t>;
+using lifetime_miniram64 = basic_lifetime_miniram<uint64_t, uint32_t>;
+using lifetime_miniram = basic_lifetime_miniram<size_t, uint32_t>;
+
+}
+
+namespace cth::dt {
+
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr basic_lifetime_miniram<SizeType, IndexType, Config>::basic_lifetime_miniram(
+    size_type capacity,
+    size_t initial_alloc_capacity
+) : _capacity{capacity}, _transientBegin{capacity}, _ram{0, initial_alloc_capacity} {}
+
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_lifetime_miniram<SizeType, IndexType, Config>::allocate(size_type size) -> alloc_type {
+    return allocateResident(size, [this](size_type s) { return _ram.allocate(s); });
+}
+
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_lifetime_miniram<SizeType, IndexType, Config>::allocate(
+    size_type size,
+    size_type alignment
+) -> alloc_type {
+    CTH_CRITICAL(!std::has_single_bit(alignment), "alignment must be a power of two") {}
+
+    // worst case padding must fit into the grown region as well, saturates for requests that can't fit anyway
+    auto const padding = alignment - 1;
+    auto const maxSize = std::numeric_limits<size_type>::max();
+    auto const padded = size > maxSize - padding ? maxSize : static_cast<size_type>(size + padding);
+
+    return allocateResident(
+        padded,
+        [this, size, alignment](size_type) { return _ram.allocate(size, alignment); }
+    );
+}
+
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr auto basic_lifetime_miniram<SizeType, IndexType, Config>::allocate_transient(
+    size_type size,
+    size_type alignment
+) -> size_type {
+    CTH_CRITICAL(!std::has_single_bit(alignment), "alignment must be a power of two") {}
+
+    if(size > _transientBegin)
+        return NO_SPACE;
+
+    auto const offset = (_transientBegin - size) & ~(alignment - 1);
+
+    // the resident region only gives up its free tail
+    if(offset < _ram.capacity() && !_ram.resize_in_place(offset))
+        return NO_SPACE;
+
+    _transientBegin = offset;
+    return offset;
+}
+
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_lifetime_miniram<SizeType, IndexType, Config>::rewind_transient(size_type marker) {
+    CTH_CRITICAL(marker < _transientBegin || marker > capacity(), "marker outside the transient stack") {}
+
+    _transientBegin = marker;
+}
+
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr void basic_lifetime_miniram<SizeType, IndexType, Config>::clear() {
+    _ram.clear();
+    free_transient();
+}
+
+template<uint SizeType, uint IndexType, mini_config Config>
+template<class AllocFn>
+constexpr auto basic_lifetime_miniram<SizeType, IndexType, Config>::allocateResident(
+    size_type size,
+    AllocFn&& alloc_fn
+) -> alloc_type {
+    auto alloc = alloc_fn(size);
+
+    while(alloc.id == INVALID_INDEX && growResident(size))
+        alloc = alloc_fn(size);
+
+    return alloc;
+}
+
+template<uint SizeType, uint IndexType, mini_config Config>
+constexpr bool basic_lifetime_miniram<SizeType, IndexType, Config>::growResident(size_type size) {
+    auto const current = _ram.capacity();
+    auto const available = _transientBegin - current;
+    if(available == 0)
+        return false;
+
+    // doubling, at least twice the request so the grown tail lands in a bin that serves it,
+    // at least one element so every failed attempt makes progress (e.g. size 0 on an empty ram)
+    auto const request = size > available / 2 ? available : static_cast<size_type>(size * 2);
+    auto const growth = std::max({current, request, size_type{1}});
+
+    return _ram.resize_in_place(current + std::min(growth, available));
+}
+
+}
@@ -0,0 +1,389 @@
+#pragma once
+#include "cth/data/miniram.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace cth::dt {
+
+/**
+ * executes miniram move plans (e.g. defragmentation reports) on real memory
+ * @details
+ * - moves are executed as if they ran in order
+ * - consecutive moves are batched while no move writes memory another move of the batch reads or writes,
+ *   big batches are split across threads
+ * - self overlapping moves run as a single memmove
+ * - copies run as memcpy calls of at most @ref block_size() bytes, the block is also the unit batches
+ *   are split across threads with
+ * - no explicit non-temporal stores, blocks below the libc streaming threshold stay on the cached path
+ * - worker threads are started on the first parallel batch and reused, copies of a mover share them
+ */
+class mini_mover {
+public:
+    static constexpr size_t DEFAULT_PARALLEL_THRESHOLD = 4 * 1024 * 1024;
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 1024 * 1024;
+
+    struct stats {
+        size_t batches = 0;
+        /**
+         * batches split across threads
+         */
+        size_t parallelBatches = 0;
+    };
+
+    /**
+     * constructs
+     * @param thread_count max threads used per batch (including the calling thread), >= 1
+     * @param parallel_threshold min batch size (in bytes) to run in parallel
+     * @param block_size max size of a single memcpy (in bytes), >= 1
+     */
+    explicit mini_mover(
+        size_t thread_count = std::max(std::thread::hardware_concurrency(), 1u),
+        size_t parallel_threshold = DEFAULT_PARALLEL_THRESHOLD,
+        size_t block_size = DEFAULT_BLOCK_SIZE
+    );
+
+    /**
+     * executes the moves
+     * @param moves to execute (in elements)
+     * @param base pointer of the memory the moves refer to
+     * @param element_size in bytes
+     */
+    template<uint SizeType>
+    stats execute(std::span<basic_mini_memmove<SizeType> const> moves, void* base, size_t element_size) const;
+
+    /**
+     * executes the moves of a defragmentation report
+     * @param report to execute
+     * @param base pointer of the memory the report refers to
+     * @param element_size in bytes
+     */
+    template<uint SizeType, uint IndexType>
+    stats execute(
+        basic_mini_defrag<SizeType, IndexType> const& report,
+        void* base,
+        size_t element_size
+    ) const {
+        return execute(std::span{report.moves}, base, element_size);
+    }
+
+private:
+    struct copy {
+        size_t src;
+        size_t dst;
+        size_t size;
+    };
+
+    /**
+     * disjoint [begin, end) ranges, touching ranges are merged
+     */
+    class range_set {
+    public:
+        [[nodiscard]] bool overlaps(size_t begin, size_t end) const;
+        void insert(size_t begin, size_t end);
+        void clear() { _ranges.clear(); }
+
+    private:
+        std::map<size_t, size_t> _ranges{};
+    };
+
+    struct batch {
+        std::vector<copy> copies{};
+        size_t bytes = 0;
+        range_set srcs{};
+        range_set dsts{};
+
+        /**
+         * true if running c together with the batch could change the result of the in order execution
+         */
+        [[nodiscard]] bool conflicts(copy const& c) const;
+        void add(copy const& c);
+        void clear();
+    };
+
+    class worker_pool;
+
+    void flush(batch& b, std::byte* base, stats& result) const;
+    void copyBlocks(copy const& c, std::byte* base) const;
+
+    size_t _threadCount;
+    size_t _parallelThreshold;
+    size_t _blockSize;
+
+    std::shared_ptr<worker_pool> _workers;
+
+public:
+    [[nodiscard]] size_t thread_count() const { return _threadCount; }
+    [[nodiscard]] size_t parallel_threshold() const { return _parallelThreshold; }
+    [[nodiscard]] size_t block_size() const { return _blockSize; }
+};
+
+/**
+ * threads of a @ref mini_mover, runs one job at a time
+ */
+class mini_mover::worker_pool {
+public:
+    explicit worker_pool(size_t worker_count) : _workerCount{worker_count} {}
+    ~worker_pool();
+
+    /**
+     * calls job(i) for every i in [0, count), job(0) runs on the calling thread
+     * @pre count <= worker count + 1
+     */
+    template<class Fn>
+    void run(size_t count, Fn const& job);
+
+private:
+    void work(size_t index);
+
+    size_t _workerCount;
+
+    std::mutex _runMutex{};
+
+    std::mutex _mutex{};
+    std::condition_variable _wake{};
+    std::condition_variable _done{};
+
+    void const* _job = nullptr;
+    void (*_invoke)(void const*, size_t) = nullptr;
+    size_t _active = 0;
+    size_t _pending = 0;
+    size_t _generation = 0;
+    bool _stop = false;
+
+    // last member, stopped before the state above is destroyed
+    std::vector<std::thread> _threads{};
+
+public:
+    worker_pool(worker_pool const& other) = delete;
+    worker_pool(worker_pool&& other) = delete;
+    worker_pool& operator=(worker_pool const& other) = delete;
+    worker_pool& operator=(worker_pool&& other) = delete;
+};
+
+}
+
+namespace cth::dt {
+
+inline mini_mover::mini_mover(size_t thread_count, size_t parallel_threshold, size_t block_size) :
+    _threadCount{std::max<size_t>(thread_count, 1)},
+    _parallelThreshold{parallel_threshold},
+    _blockSize{std::max<size_t>(block_size, 1)},
+    _workers{_threadCount > 1 ? std::make_shared<worker_pool>(_threadCount - 1) : nullptr} {}
+
+template<uint SizeType>
+auto mini_mover::execute(
+    std::span<basic_mini_memmove<SizeType> const> moves,
+    void* base,
+    size_t element_size
+) const -> stats {
+    auto* const bytes = static_cast<std::byte*>(base);
+
+    stats result{};
+    batch current{};
+
+    for(auto const& move : moves) {
+        copy const c{
+            .src = static_cast<size_t>(move.srcOffset) * element_size,
+            .dst = static_cast<size_t>(move.dstOffset) * element_size,
+            .size = static_cast<size_t>(move.size) * element_size,
+        };
+
+        if(c.size == 0 || c.src == c.dst)
+            continue;
+
+        auto const [begin, end] = std::minmax(c.src, c.dst);
+
+        // overlapping chain, must run in order
+        if(end - begin < c.size) {
+            flush(current, bytes, result);
+
+            std::memmove(bytes + c.dst, bytes + c.src, c.size);
+            continue;
+        }
+
+        if(current.conflicts(c))
+            flush(current, bytes, result);
+
+        current.add(c);
+    }
+
+    flush(current, bytes, result);
+    return result;
+}
+
+inline void mini_mover::flush(batch& b, std::byte* base, stats& result) const {
+    if(b.copies.empty())
+        return;
+
+    ++result.batches;
+
+    if(_threadCount == 1 || b.bytes < _parallelThreshold) {
+        for(auto const& c : b.copies)
+            copyBlocks(c, base);
+
+        b.clear();
+        return;
+    }
+
+    ++result.parallelBatches;
+
+    // split the batch into equally sized work lists, cutting copies where necessary
+    auto const threads = std::min(_threadCount, (b.bytes + _blockSize - 1) / _blockSize);
+    auto const share = (b.bytes + threads - 1) / threads;
+
+    std::vector<std::vector<copy>> work(threads);
+    size_t worker = 0;
+    size_t assigned = 0;
+
+    for(auto c : b.copies) {
+        while(c.size > 0) {
+            auto const chunk = std::min(c.size, share - assigned);
+
+            work[worker].push_back({.src = c.src, .dst = c.dst, .size = chunk});
+
+            c.src += chunk;
+            c.dst += chunk;
+            c.size -= chunk;
+            assigned += chunk;
+
+            if(assigned == share && worker + 1 < threads) {
+                ++worker;
+                assigned = 0;
+            }
+        }
+    }
+
+    _workers->run(threads, [this, &work, base](size_t index) {
+        for(auto const& c : work[index])
+            copyBlocks(c, base);
+    });
+
+    b.clear();
+}
+
+inline void mini_mover::copyBlocks(copy const& c, std::byte* base) const {
+    for(size_t offset = 0; offset < c.size; offset += _blockSize) {
+        auto const size = std::min(_blockSize, c.size - offset);
+        std::memcpy(base + c.dst + offset, base + c.src + offset, size);
+    }
+}
+
+inline bool mini_mover::range_set::overlaps(size_t begin, size_t end) const {
+    // last range starting before end, ranges are disjoint so no earlier one can reach further
+    auto it = _ranges.lower_bound(end);
+    if(it == _ranges.begin())
+        return false;
+
+    return std::prev(it)->second > begin;
+}
+
+inline void mini_mover::range_set::insert(size_t begin, size_t end) {
+    auto it = _ranges.upper_bound(begin);
+
+    if(it != _ranges.begin() && std::prev(it)->second >= begin) {
+        --it;
+        begin = it->first;
+    }
+
+    while(it != _ranges.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = _ranges.erase(it);
+    }
+
+    _ranges.emplace(begin, end);
+}
+
+inline bool mini_mover::batch::conflicts(copy const& c) const {
+    auto const srcEnd = c.src + c.size;
+    auto const dstEnd = c.dst + c.size;
+
+    // reads an earlier write, overwrites an earlier read or races an earlier write
+    return dsts.overlaps(c.src, srcEnd) || srcs.overlaps(c.dst, dstEnd) || dsts.overlaps(c.dst, dstEnd);
+}
+
+inline void mini_mover::batch::add(copy const& c) {
+    copies.push_back(c);
+    bytes += c.size;
+    srcs.insert(c.src, c.src + c.size);
+    dsts.insert(c.dst, c.dst + c.size);
+}
+
+inline void mini_mover::batch::clear() {
+    copies.clear();
+    bytes = 0;
+    srcs.clear();
+    dsts.clear();
+}
+
+inline mini_mover::worker_pool::~worker_pool() {
+    {
+        std::scoped_lock lock{_mutex};
+        _stop = true;
+    }
+    _wake.notify_all();
+
+    for(auto& thread : _threads)
+        thread.join();
+}
+
+template<class Fn>
+void mini_mover::worker_pool::run(size_t count, Fn const& job) {
+    std::scoped_lock runLock{_runMutex};
+
+    CTH_CRITICAL(count > _workerCount + 1, "more jobs than workers") {}
+
+    // started on first use, movers which never run in parallel don't hold threads
+    if(_threads.empty()) {
+        _threads.reserve(_workerCount);
+        for(size_t i = 1; i <= _workerCount; ++i)
+            _threads.emplace_back([this, i] { work(i); });
+    }
+
+    {
+        std::scoped_lock lock{_mutex};
+        _job = &job;
+        _invoke = [](void const* fn, size_t index) { (*static_cast<Fn const*>(fn))(index); };
+        _active = count;
+        _pending = count - 1;
+        ++_generation;
+    }
+    _wake.notify_all();
+
+    job(0);
+
+    std::unique_lock lock{_mutex};
+    _done.wait(lock, [this] { return _pending == 0; });
+}
+
+inline void mini_mover::worker_pool::work(size_t index) {
+    size_t seen = 0;
+
+    std::unique_lock lock{_mutex};
+    while(true) {
+        _wake.wait(lock, [this, seen] { return _stop || _generation != seen; });
+        if(_stop)
+            return;
+
+        seen = _generation;
+        if(index >= _active)
+            continue;
+
+        lock.unlock();
+        _invoke(_job, index);
+        lock.lock();
+
+        if(--_pending == 0)
+            _done.notify_one();
+    }
+}
+
+}
@@ -0,0 +1,455 @@
+#pragma once
+#include "cth/data/miniram.hpp"
+#include "cth/io/log.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cth::dt {
+
+/**
+ * recorded call of a @ref mini_trace
+ */
+enum class MiniTraceOp : uint32_t {
+    ALLOCATE, ///< value: size, arg: alignment (1 if unaligned)
+    FREE, ///< value: number of the freed allocation
+    DEFRAGMENT, ///< full defragmentation
+    DEFRAGMENT_STEP, ///< value: budget
+    RESIZE, ///< value: new capacity, defragmenting
+    RESIZE_IN_PLACE, ///< value: new capacity
+    CLEAR,
+};
+
+struct mini_trace_event {
+    MiniTraceOp op;
+    uint64_t value = 0;
+    uint64_t arg = 0;
+};
+
+/**
+ * binary trace of the calls on a miniram
+ * @details allocator independent, allocations are referenced by their number (order of ALLOCATE events)
+ */
+struct mini_trace {
+    uint64_t capacity = 0; ///< initial capacity
+    uint64_t allocations = 0; ///< number of ALLOCATE events
+    std::vector<mini_trace_event> events{};
+
+    /**
+     * serializes the trace into a binary blob, only portable between identical platforms
+     */
+    [[nodiscard]] std::vector<std::byte> serialize() const;
+
+    /**
+     * deserializes a trace from a @ref serialize() blob, e.g. read from a file
+     * @throws cth::except::default_exception if the blob is truncated, not a trace or inconsistent
+     */
+    [[nodiscard]] static mini_trace deserialize(std::span<std::byte const> blob);
+
+    /**
+     * checks the events against each other
+     * @return first inconsistency or nullptr if the trace can be replayed
+     * @details ops must be known, alignments powers of two, frees must reference earlier allocations
+     *          and the allocation count must match the ALLOCATE events
+     */
+    [[nodiscard]] char const* inconsistency() const;
+
+private:
+    // blob: [header][events]
+    struct header {
+        uint32_t magic = 0x4D54'5243; // "MTRC"
+        uint32_t version = 1;
+        uint64_t capacity;
+        uint64_t allocations;
+        uint64_t events;
+    };
+};
+
+/**
+ * records every call on the owned miniram into a @ref mini_trace
+ * @tparam Ram @ref basic_miniram
+ */
+template<class Ram>
+class mini_recorder {
+public:
+    using ram_type = Ram;
+    using size_type = typename Ram::size_type;
+    using index_type = typename Ram::index_type;
+    using alloc_type = typename Ram::alloc_type;
+    using defrag_type = typename Ram::defrag_type;
+    using defrag_step_type = typename Ram::defrag_step_type;
+
+    /**
+     * constructs the recorded ram
+     * @param capacity of ram (in elements)
+     * @param args forwarded to the ram constructor after capacity
+     */
+    template<class... Args>
+    explicit mini_recorder(size_type capacity, Args&&... args) :
+        _ram(capacity, std::forward<Args>(args)...),
+        _trace{.capacity = capacity} {}
+
+    [[nodiscard]] alloc_type allocate(size_type size) { return record(_ram.allocate(size), size, 1); }
+    [[nodiscard]] alloc_type allocate(size_type size, size_type alignment) {
+        return record(_ram.allocate(size, alignment), size, alignment);
+    }
+    /**
+     * recorded as single allocations
+     */
+    [[nodiscard]] std::vector<alloc_type> allocate_n(std::span<size_type const> sizes);
+
+    void free(alloc_type allocation);
+    /**
+     * recorded as single frees
+     */
+    void free_n(std::span<alloc_type const> allocations);
+
+    [[nodiscard]] defrag_type defragment();
+    [[nodiscard]] defrag_step_type defragment_step(size_type max_moved);
+    [[nodiscard]] defrag_type resize(size_type new_capacity);
+    bool resize_in_place(size_type new_capacity);
+    void clear();
+
+    [[nodiscard]] size_type size_of(alloc_type allocation) const { return _ram.size_of(allocation); }
+
+private:
+    [[nodiscard]] alloc_type record(alloc_type allocation, size_type size, size_type alignment);
+    void recordFree(alloc_type allocation);
+
+    Ram _ram;
+    mini_trace _trace;
+
+    // live handle id -> allocation number
+    std::unordered_map<index_type, uint64_t> _numbers{};
+
+public:
+    [[nodiscard]] Ram const& ram() const { return _ram; }
+    [[nodiscard]] mini_trace const& trace() const { return _trace; }
+};
+
+/**
+ * latency percentiles of a @ref mini_replay()
+ */
+struct mini_latency {
+    size_t count = 0;
+    std::chrono::nanoseconds p50{};
+    std::chrono::nanoseconds p90{};
+    std::chrono::nanoseconds p99{};
+    std::chrono::nanoseconds max{};
+};
+
+struct mini_replay_report {
+    mini_latency all{};
+    mini_latency allocate{};
+    mini_latency free{};
+
+    size_t failedAllocs = 0; ///< includes allocations which failed in the recording
+    float peakFragmentation = 0.0f; ///< max @ref basic_miniram::fragmentation() after any call
+    uint64_t movedElements = 0; ///< by defragment / defragment_step / resize
+    std::chrono::nanoseconds total{}; ///< summed call time
+};
+
+/**
+ * replays a trace against an allocator configuration
+ * @tparam Ram @ref basic_miniram to replay against
+ * @param trace to replay
+ * @param initial_alloc_capacity of the ram (in allocations), >= 1
+ * @details frees of allocations which failed in the replay are skipped
+ * @throws cth::except::default_exception if the trace is inconsistent, see @ref mini_trace::inconsistency()
+ */
+template<class Ram>
+[[nodiscard]] mini_replay_report mini_replay(
+    mini_trace const& trace,
+    size_t initial_alloc_capacity = 128 * 1024
+);
+
+}
+
+namespace cth::dt {
+
+inline std::vector<std::byte> mini_trace::serialize() const {
+    header const head{.capacity = capacity, .allocations = allocations, .events = events.size()};
+
+    std::vector<std::byte> blob(sizeof(head) + events.size() * sizeof(mini_trace_event));
+    std::memcpy(blob.data(), &head, sizeof(head));
+    std::memcpy(blob.data() + sizeof(head), events.data(), events.size() * sizeof(mini_trace_event));
+
+    return blob;
+}
+
+inline mini_trace mini_trace::deserialize(std::span<std::byte const> blob) {
+    header head{};
+
+    CTH_STABLE_ERR(blob.size() < sizeof(head), "trace is truncated") {
+        details->add("size: {}", blob.size());
+        throw details->exception();
+    }
+
+    std::memcpy(&head, blob.data(), sizeof(head));
+
+    CTH_STABLE_ERR(head.magic != header{}.magic || head.version != header{}.version, "not a miniram trace") {
+        details->add("magic: {}, version: {}", head.magic, head.version);
+        throw details->exception();
+    }
+
+    // division keeps a forged event count from overflowing the size check
+    auto const maxEvents = (blob.size() - sizeof(head)) / sizeof(mini_trace_event);
+
+    CTH_STABLE_ERR(head.events > maxEvents, "trace is truncated") {
+        details->add("size: {}, events: {}", blob.size(), head.events);
+        throw details->exception();
+    }
+
+    auto const eventCount = static_cast<size_t>(head.events);
+
+    mini_trace trace{.capacity = head.capacity, .allocations = head.allocations};
+    trace.events.resize(eventCount);
+    std::memcpy(trace.events.data(), blob.data() + sizeof(head), eventCount * sizeof(mini_trace_event));
+
+    auto const* const inconsistency = trace.inconsistency();
+    CTH_STABLE_ERR(inconsistency != nullptr, "trace is inconsistent") {
+        details->add("{}", inconsistency);
+        throw details->exception();
+    }
+
+    return trace;
+}
+
+inline char const* mini_trace::inconsistency() const {
+    uint64_t allocated = 0;
+
+    for(auto const& event : events) {
+        switch(event.op) {
+            case MiniTraceOp::ALLOCATE:
+                if(!std::has_single_bit(event.arg))
+                    return "alignment is not a power of two";
+                ++allocated;
+                break;
+            case MiniTraceOp::FREE:
+                if(event.value >= allocated)
+                    return "free of an allocation that wasn't made yet";
+                break;
+            case MiniTraceOp::DEFRAGMENT:
+            case MiniTraceOp::DEFRAGMENT_STEP:
+            case MiniTraceOp::RESIZE:
+            case MiniTraceOp::RESIZE_IN_PLACE:
+            case MiniTraceOp::CLEAR: break;
+            default: return "unknown op";
+        }
+    }
+
+    if(allocated != allocations)
+        return "allocation count doesn't match the events";
+
+    return nullptr;
+}
+
+template<class Ram>
+auto mini_recorder<Ram>::allocate_n(std::span<size_type const> sizes) -> std::vector<alloc_type> {
+    auto allocations = _ram.allocate_n(sizes);
+
+    for(size_t i = 0; i < sizes.size(); ++i)
+        static_cast<void>(record(allocations[i], sizes[i], 1));
+
+    return allocations;
+}
+
+template<class Ram>
+void mini_recorder<Ram>::free(alloc_type allocation) {
+    recordFree(allocation);
+    _ram.free(allocation);
+}
+
+template<class Ram>
+void mini_recorder<Ram>::free_n(std::span<alloc_type const> allocations) {
+    for(auto const& allocation : allocations)
+        recordFree(allocation);
+
+    _ram.free_n(allocations);
+}
+
+template<class Ram>
+auto mini_recorder<Ram>::defragment() -> defrag_type {
+    _trace.events.push_back({.op = MiniTraceOp::DEFRAGMENT});
+    return _ram.defragment();
+}
+
+template<class Ram>
+auto mini_recorder<Ram>::defragment_step(size_type max_moved) -> defrag_step_type {
+    _trace.events.push_back({.op = MiniTraceOp::DEFRAGMENT_STEP, .value = max_moved});
+    return _ram.defragment_step(max_moved);
+}
+
+template<class Ram>
+auto mini_recorder<Ram>::resize(size_type new_capacity) -> defrag_type {
+    _trace.events.push_back({.op = MiniTraceOp::RESIZE, .value = new_capacity});
+    return _ram.resize(new_capacity);
+}
+
+template<class Ram>
+bool mini_recorder<Ram>::resize_in_place(size_type new_capacity) {
+    _trace.events.push_back({.op = MiniTraceOp::RESIZE_IN_PLACE, .value = new_capacity});
+    return _ram.resize_in_place(new_capacity);
+}
+
+template<class Ram>
+void mini_recorder<Ram>::clear() {
+    _trace.events.push_back({.op = MiniTraceOp::CLEAR});
+    _numbers.clear();
+    _ram.clear();
+}
+
+template<class Ram>
+auto mini_recorder<Ram>::record(alloc_type allocation, size_type size, size_type alignment) -> alloc_type {
+    auto const number = _trace.allocations++;
+    _trace.events.push_back({.op = MiniTraceOp::ALLOCATE, .value = size, .arg = alignment});
+
+    if(allocation.id != Ram::INVALID_INDEX)
+        _numbers[allocation.id] = number;
+
+    return allocation;
+}
+
+template<class Ram>
+void mini_recorder<Ram>::recordFree(alloc_type allocation) {
+    auto const it = _numbers.find(allocation.id);
+    CTH_CRITICAL(it == _numbers.end(), "freed allocation is not live") {}
+
+    _trace.events.push_back({.op = MiniTraceOp::FREE, .value = it->second});
+    _numbers.erase(it);
+}
+
+namespace dev {
+    inline mini_latency to_latency(std::vector<std::chrono::nanoseconds>& samples) {
+        if(samples.empty())
+            return {};
+
+        std::ranges::sort(samples);
+
+        auto const at = [&](size_t percent) { return samples[(samples.size() - 1) * percent / 100]; };
+        return {.count = samples.size(), .p50 = at(50), .p90 = at(90), .p99 = at(99), .max = samples.back()};
+    }
+}
+
+template<class Ram>
+mini_replay_report mini_replay(mini_trace const& trace, size_t initial_alloc_capacity) {
+    using size_type = typename Ram::size_type;
+    using index_type = typename Ram::index_type;
+    using alloc_type = typename Ram::alloc_type;
+    using clock = std::chrono::steady_clock;
+
+    auto const* const inconsistency = trace.inconsistency();
+    CTH_STABLE_ERR(inconsistency != nullptr, "trace is inconsistent") {
+        details->add("{}", inconsistency);
+        throw details->exception();
+    }
+
+    mini_replay_report report{};
+
+    Ram ram{static_cast<size_type>(trace.capacity), initial_alloc_capacity};
+
+    std::vector<alloc_type> allocations(trace.allocations, alloc_type{Ram::NO_SPACE, Ram::INVALID_INDEX});
+    // live handle id -> allocation number, defragmentation reports are keyed by id
+    std::unordered_map<index_type, uint64_t> numbers{};
+
+    std::vector<std::chrono::nanoseconds> allSamples{};
+    std::vector<std::chrono::nanoseconds> allocSamples{};
+    std::vector<std::chrono::nanoseconds> freeSamples{};
+    allSamples.reserve(trace.events.size());
+
+    uint64_t nextNumber = 0;
+
+    auto const applyReport = [&](auto const& defrag) {
+        for(auto const& alloc : defrag.updatedAllocs)
+            allocations[numbers.at(alloc.id)] = alloc;
+        for(auto const& move : defrag.moves)
+            report.movedElements += move.size;
+    };
+
+    for(auto const& event : trace.events) {
+        auto const start = clock::now();
+
+        switch(event.op) {
+            case MiniTraceOp::ALLOCATE: {
+                auto const size = static_cast<size_type>(event.value);
+                auto const alignment = static_cast<size_type>(event.arg);
+
+                auto const alloc = alignment > 1 ? ram.allocate(size, alignment) : ram.allocate(size);
+                allSamples.push_back(clock::now() - start);
+                allocSamples.push_back(allSamples.back());
+
+                auto const number = nextNumber++;
+                allocations[number] = alloc;
+
+                if(alloc.id == Ram::INVALID_INDEX)
+                    ++report.failedAllocs;
+                else
+                    numbers[alloc.id] = number;
+                break;
+            }
+            case MiniTraceOp::FREE: {
+                auto& alloc = allocations[event.value];
+                if(alloc.id == Ram::INVALID_INDEX)
+                    continue;
+
+                ram.free(alloc);
+                allSamples.push_back(clock::now() - start);
+                freeSamples.push_back(allSamples.back());
+
+                numbers.erase(alloc.id);
+                alloc = {Ram::NO_SPACE, Ram::INVALID_INDEX};
+                break;
+            }
+            case MiniTraceOp::DEFRAGMENT: {
+                auto const defrag = ram.defragment();
+                allSamples.push_back(clock::now() - start);
+                applyReport(defrag);
+                break;
+            }
+            case MiniTraceOp::DEFRAGMENT_STEP: {
+                auto const step = ram.defragment_step(static_cast<size_type>(event.value));
+                allSamples.push_back(clock::now() - start);
+                applyReport(step.report);
+                break;
+            }
+            case MiniTraceOp::RESIZE: {
+                auto const defrag = ram.resize(static_cast<size_type>(event.value));
+                allSamples.push_back(clock::now() - start);
+                applyReport(defrag);
+                break;
+            }
+            case MiniTraceOp::RESIZE_IN_PLACE: {
+                static_cast<void>(ram.resize_in_place(static_cast<size_type>(event.value)));
+                allSamples.push_back(clock::now() - start);
+                break;
+            }
+            case MiniTraceOp::CLEAR: {
+                ram.clear();
+                allSamples.push_back(clock::now() - start);
+
+                numbers.clear();
+                std::ranges::fill(allocations, alloc_type{Ram::NO_SPACE, Ram::INVALID_INDEX});
+                break;
+            }
+        }
+
+        report.total += allSamples.back();
+        report.peakFragmentation = std::max(report.peakFragmentation, ram.fragmentation());
+    }
+
+    report.all = dev::to_latency(allSamples);
+    report.allocate = dev::to_latency(allocSamples);
+    report.free = dev::to_latency(freeSamples);
+
+    return report;
+}
+
+}
@@ -1,9 +1,20 @@
 #pragma once
 // heavily inspired by Sebastian Aaltonen: https://github.com/sebbbi/OffsetAllocator
 
+#include "cth/constants.hpp"
+#include "cth/data/poly_vector.hpp"
+
 #include <array>
 #include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace cth::dt {
@@ -33,6 +44,304 @@ namespace dev {
     };
 }
 
+/**
+ * node storage layout of @ref basic_miniram
+ */
+enum class MiniNodeLayout {
+    AOS, ///< array of @ref dev::basic_mini_node
+    SOA, ///< one array per node member, used flags as bitset
+};
+
+/**
+ * free block selection of @ref basic_miniram
+ */
+enum class MiniPlacement {
+    GOOD_FIT, ///< first node of the smallest non empty bin that fits, O(1)
+    BEST_FIT, ///< smallest fitting node, also checks the bin below, linear in the bin length
+    LOWEST_ADDRESS, ///< lowest addressed node of the smallest fitting non empty bin, linear in the bin length
+};
+
+/**
+ * compile time configuration of @ref basic_miniram
+ */
+struct mini_config {
+    MiniNodeLayout layout = MiniNodeLayout::AOS; ///< node storage layout
+    MiniPlacement placement = MiniPlacement::GOOD_FIT; ///< free block selection
+    size_t binsPerLeaf = 8; ///< size classes per power of two, power of two in [4, 64], more is finer
+    bool stats = false; ///< collect @ref basic_mini_stats, compiled out if disabled
+    /**
+     * high id bits holding a per node generation, 0 or [2, index bits / 2]
+     * @details stale handles (freed, node reused) are caught on free / size_of
+     * @note compiled out in release builds, ids are plain node indices there
+     */
+    size_t generationBits = 0;
+};
+
+namespace dev {
+    // array of structs node storage
+    template<uint SizeType, uint IndexType>
+    class mini_aos_nodes {
+    public:
+        using node_type = basic_mini_node<SizeType, IndexType>;
+
+        [[nodiscard]] constexpr node_type& operator[](size_t index) { return _nodes[index]; }
+        [[nodiscard]] constexpr node_type const& operator[](size_t index) const { return _nodes[index]; }
+
+        constexpr void resize(size_t size) { _nodes.resize(size); }
+
+        /**
+         * calls on_used(index) for used and on_free(index) for unused nodes
+         */
+        template<class UsedFn, class FreeFn>
+        constexpr void visit(UsedFn&& on_used, FreeFn&& on_free) const {
+            for(size_t i = 0; i < _nodes.size(); ++i) {
+                if(_nodes[i].used)
+                    on_used(i);
+                else
+                    on_free(i);
+            }
+        }
+
+        /**
+         * size of the raw data of size nodes (in bytes)
+         */
+        [[nodiscard]] static constexpr size_t byte_size(size_t size) { return size * sizeof(node_type); }
+        [[nodiscard]] constexpr size_t byte_size() const { return byte_size(_nodes.size()); }
+        /**
+         * copies the raw node data to dst, @ref byte_size() bytes
+         */
+        void write(std::byte* dst) const { std::memcpy(dst, _nodes.data(), byte_size()); }
+        /**
+         * resizes and copies the raw node data from src, written by @ref write()
+         * @return false if a used flag isn't a valid bool, the storage is left empty then
+         */
+        [[nodiscard]] bool read(std::byte const* src, size_t size) {
+            // loading a bool that isn't 0 or 1 is undefined, check the raw bytes before copying
+            for(size_t i = 0; i < size; ++i)
+                if(std::to_integer<unsigned>(src[i * sizeof(node_type) + offsetof(node_type, used)]) > 1) {
+                    _nodes.clear();
+                    return false;
+                }
+
+            _nodes.resize(size);
+            std::memcpy(_nodes.data(), src, byte_size());
+            return true;
+        }
+
+        [[nodiscard]] constexpr size_t size() const { return _nodes.size(); }
+        [[nodiscard]] constexpr bool empty() const { return _nodes.empty(); }
+
+    private:
+        std::vector<node_type> _nodes{};
+    };
+
+    // struct of arrays node storage, used flags are packed into words
+    template<uint SizeType, uint IndexType>
+    class mini_soa_nodes {
+    public:
+        using node_type = basic_mini_node<SizeType, IndexType>;
+        using word_type = uint64_t;
+
+    private:
+        static constexpr size_t WORD_BITS = sizeof(word_type) * 8;
+
+        enum Member : size_t { OFFSET, SIZE, BIN_PREV, BIN_NEXT, NEIGHBOR_PREV, NEIGHBOR_NEXT, USED };
+
+        using storage_type =
+            poly_vector<SizeType, SizeType, IndexType, IndexType, IndexType, IndexType, word_type>;
+        using member_types =
+            std::tuple<SizeType, SizeType, IndexType, IndexType, IndexType, IndexType, word_type>;
+
+        class used_reference {
+        public:
+            constexpr used_reference(word_type& word, word_type mask) : _word{word}, _mask{mask} {}
+
+            constexpr used_reference& operator=(bool used) {
+                _word = used ? _word | _mask : _word & ~_mask;
+                return *this;
+            }
+            constexpr used_reference& operator=(used_reference const& other) {
+                return *this = static_cast<bool>(other);
+            }
+
+            [[nodiscard]] constexpr operator bool() const { return (_word & _mask) != 0; }
+
+        private:
+            word_type& _word;
+            word_type _mask;
+        };
+
+    public:
+        // node proxy, member names match @ref basic_mini_node
+        class reference {
+        public:
+            constexpr reference(storage_type& data, size_t index) :
+                dataOffset{data.template data<OFFSET>()[index]},
+                dataSize{data.template data<SIZE>()[index]},
+                binListPrev{data.template data<BIN_PREV>()[index]},
+                binListNext{data.template data<BIN_NEXT>()[index]},
+                neighborPrev{data.template data<NEIGHBOR_PREV>()[index]},
+                neighborNext{data.template data<NEIGHBOR_NEXT>()[index]},
+                used{data.template data<USED>()[index / WORD_BITS], word_type{1} << (index % WORD_BITS)} {}
+
+            constexpr reference& operator=(node_type const& node) {
+                dataOffset = node.dataOffset;
+                dataSize = node.dataSize;
+                binListPrev = node.binListPrev;
+                binListNext = node.binListNext;
+                neighborPrev = node.neighborPrev;
+                neighborNext = node.neighborNext;
+                used = node.used;
+                return *this;
+            }
+
+            SizeType& dataOffset;
+            SizeType& dataSize;
+            IndexType& binListPrev;
+            IndexType& binListNext;
+            IndexType& neighborPrev;
+            IndexType& neighborNext;
+            used_reference used;
+        };
+
+        constexpr mini_soa_nodes() : _data{make_sizes(0)} {}
+
+        [[nodiscard]] constexpr reference operator[](size_t index) { return reference{_data, index}; }
+        [[nodiscard]] constexpr node_type operator[](size_t index) const {
+            return {
+                .dataOffset = _data.template data<OFFSET>()[index],
+                .dataSize = _data.template data<SIZE>()[index],
+                .binListPrev = _data.template data<BIN_PREV>()[index],
+                .binListNext = _data.template data<BIN_NEXT>()[index],
+                .neighborPrev = _data.template data<NEIGHBOR_PREV>()[index],
+                .neighborNext = _data.template data<NEIGHBOR_NEXT>()[index],
+                .used = ((_data.template data<USED>()[index / WORD_BITS] >> (index % WORD_BITS)) & 1) != 0,
+            };
+        }
+
+        constexpr void resize(size_t size) {
+            storage_type data{make_sizes(size)};
+            auto const copied = std::min(size, _size);
+
+            copyMember<OFFSET>(data, copied, SizeType{0});
+            copyMember<SIZE>(data, copied, SizeType{0});
+            copyMember<BIN_PREV>(data, copied, node_type::UNUSED);
+            copyMember<BIN_NEXT>(data, copied, node_type::UNUSED);
+            copyMember<NEIGHBOR_PREV>(data, copied, node_type::UNUSED);
+            copyMember<NEIGHBOR_NEXT>(data, copied, node_type::UNUSED);
+
+            auto const words = data.template size<USED>();
+            auto const copiedWords = (copied + WORD_BITS - 1) / WORD_BITS;
+            std::ranges::fill_n(data.template data<USED>(), words, word_type{0});
+            std::ranges::copy_n(_data.template data<USED>(), copiedWords, data.template data<USED>());
+
+            // clear stale bits past the copied range in the last copied word
+            if(copied % WORD_BITS != 0)
+                data.template data<USED>()[copied / WORD_BITS] &= (word_type{1} << (copied % WORD_BITS)) - 1;
+
+            _data = std::move(data);
+            _size = size;
+        }
+
+        /**
+         * calls on_used(index) for used and on_free(index) for unused nodes
+         * @details word at a time bit scan over the used flags
+         */
+        template<class UsedFn, class FreeFn>
+        constexpr void visit(UsedFn&& on_used, FreeFn&& on_free) const {
+            auto const* words = _data.template data<USED>();
+
+            for(size_t w = 0; w * WORD_BITS < _size; ++w) {
+                auto const base = w * WORD_BITS;
+                auto const valid = std::min(WORD_BITS, _size - base);
+                auto const validMask = valid == WORD_BITS ? ~word_type{0} : (word_type{1} << valid) - 1;
+
+                for(auto bits = words[w]; bits != 0; bits &= bits - 1)
+                    on_used(base + std::countr_zero(bits));
+
+                for(auto bits = ~words[w] & validMask; bits != 0; bits &= bits - 1)
+                    on_free(base + std::countr_zero(bits));
+            }
+        }
+
+        /**
+         * size of the raw data of size nodes (in bytes)
+         */
+        [[nodiscard]] static constexpr size_t byte_size(size_t size) {
+            size_t bytes = 0;
+            forEachMember([&]<size_t I>() { bytes += memberBytes<I>(size); });
+            return bytes;
+        }
+        [[nodiscard]] constexpr size_t byte_size() const { return byte_size(_size); }
+        /**
+         * copies the raw node data to dst member by member, @ref byte_size() bytes
+         */
+        void write(std::byte* dst) const {
+            forEachMember([&]<size_t I>() {
+                std::memcpy(dst, _data.template data<I>(), memberBytes<I>(_size));
+                dst += memberBytes<I>(_size);
+            });
+        }
+        /**
+         * resizes and copies the raw node data from src, written by @ref write()
+         * @return false if used bits past size are set
+         */
+        [[nodiscard]] bool read(std::byte const* src, size_t size) {
+            _data = storage_type{make_sizes(size)};
+            _size = size;
+
+            forEachMember([&]<size_t I>() {
+                std::memcpy(_data.template data<I>(), src, memberBytes<I>(size));
+                src += memberBytes<I>(size);
+            });
+
+            if(size % WORD_BITS == 0)
+                return true;
+            return (_data.template data<USED>()[size / WORD_BITS] >> (size % WORD_BITS)) == 0;
+        }
+
+        [[nodiscard]] constexpr size_t size() const { return _size; }
+        [[nodiscard]] constexpr bool empty() const { return _size == 0; }
+
+    private:
+        template<class Fn>
+        static constexpr void forEachMember(Fn&& fn) {
+            [&]<size_t... Is>(std::index_sequence<Is...>) {
+                (fn.template operator()<Is>(), ...);
+            }(std::make_index_sequence<USED + 1>{});
+        }
+
+        template<size_t I>
+        [[nodiscard]] static constexpr size_t memberBytes(size_t size) {
+            return make_sizes(size)[I] * sizeof(std::tuple_element_t<I, member_types>);
+        }
+
+        static constexpr std::array<size_t, 7> make_sizes(size_t size) {
+            auto const words = (size + WORD_BITS - 1) / WORD_BITS;
+            return {size, size, size, size, size, size, words};
+        }
+
+        template<size_t I, class T>
+        constexpr void copyMember(storage_type& dst, size_t copied, T fill) const {
+            std::ranges::copy_n(_data.template data<I>(), copied, dst.template data<I>());
+            std::ranges::fill_n(dst.template data<I>() + copied, dst.template size<I>() - copied, fill);
+        }
+
+        storage_type _data;
+        size_t _size = 0;
+
+    public:
+        constexpr mini_soa_nodes(mini_soa_nodes const& other) = default;
+        constexpr mini_soa_nodes(mini_soa_nodes&& other) noexcept = default;
+        constexpr mini_soa_nodes& operator=(mini_soa_nodes const& other) {
+            if(&other != this)
+                *this = mini_soa_nodes{other};
+            return *this;
+        }
+        constexpr mini_soa_nodes& operator=(mini_soa_nodes&& other) noexcept = default;
+    };
+}
+
 template<uint SizeType, uint IndexType>
 struct basic_mini_alloc {
     SizeType offset;
@@ -59,7 +368,53 @@ struct basic_mini_defrag {
 };
 
 template<uint SizeType, uint IndexType>
+struct basic_mini_defrag_step {
+    basic_mini_defrag<SizeType, IndexType> report;
+    SizeType moved;
+    bool complete;
+};
+
+/**
+ * allocation statistics of a @ref basic_miniram, sizes are in elements
+ * @tparam SizeClasses number of size classes (bins)
+ */
+template<uint SizeType, size_t SizeClasses>
+struct basic_mini_stats {
+    struct size_class {
+        size_t allocs = 0;
+        uint64_t requested = 0;
+        uint64_t granted = 0; ///< size of the free blocks the allocations were cut from
+    };
+
+    size_t allocs = 0;
+    size_t frees = 0;
+    size_t failedAllocs = 0;
+    size_t binMisses = 0; ///< allocations served from a bigger size class than requested
+    SizeType peakAllocated = 0;
+
+    size_t defragmentations = 0; ///< full and incremental
+    std::chrono::nanoseconds defragmentTime{};
+
+    std::array<size_class, SizeClasses> sizeClasses{}; ///< indexed by the size class of the request
+};
+
+/**
+ * offset allocator, manages allocations in an external range of elements
+ * @tparam Config compile time configuration, see @ref mini_config
+ */
+template<uint SizeType, uint IndexType, mini_config Config = mini_config{}>
 class basic_miniram {
+    static_assert(
+        std::has_single_bit(Config.binsPerLeaf) && Config.binsPerLeaf >= 4 && Config.binsPerLeaf <= 64,
+        "binsPerLeaf must be a power of two in [4, 64]"
+    );
+    static_assert(
+        Config.generationBits == 0
+            || (Config.generationBits >= 2
+                && Config.generationBits <= std::numeric_limits<IndexType>::digits / 2),
+        "generationBits must be 0 or in [2, index bits / 2]"
+    );
+
 public:
     using size_type = SizeType;
     using index_type = IndexType;
@@ -67,12 +422,25 @@ public:
     using regions_type = basic_mini_region<SizeType>;
     using memmove_type = basic_mini_memmove<SizeType>;
     using defrag_type = basic_mini_defrag<SizeType, IndexType>;
+    using defrag_step_type = basic_mini_defrag_step<SizeType, IndexType>;
     using node_type = dev::basic_mini_node<SizeType, IndexType>;
 
 private:
+    static constexpr MiniNodeLayout LAYOUT = Config.layout;
+    static constexpr MiniPlacement PLACEMENT = Config.placement;
+    static constexpr bool STATS = Config.stats;
+
+    // handle generations, debug builds only
+    static constexpr size_t GENERATION_BITS = debug_mode() ? Config.generationBits : 0;
+    static constexpr bool GENERATIONS = GENERATION_BITS > 0;
+    static constexpr size_t NODE_ID_BITS = std::numeric_limits<IndexType>::digits - GENERATION_BITS;
+    static constexpr IndexType NODE_ID_MASK = invalid<IndexType>() >> GENERATION_BITS;
+    // the all ones generation is skipped, encoded ids never equal INVALID_INDEX
+    static constexpr IndexType GENERATION_COUNT = (IndexType{1} << GENERATION_BITS) - 1;
+
     // Bin configuration - calculated from BINS_PER_LEAF
-    static constexpr size_t BINS_PER_LEAF = 8;
-    static constexpr size_t MANTISSA_BITS = std::countr_zero(BINS_PER_LEAF); // log2(8) = 3
+    static constexpr size_t BINS_PER_LEAF = Config.binsPerLeaf;
+    static constexpr size_t MANTISSA_BITS = std::countr_zero(BINS_PER_LEAF);
     static constexpr size_type MANTISSA_VALUE = size_type{1} << MANTISSA_BITS;
     static constexpr size_type MANTISSA_MASK = MANTISSA_VALUE - 1;
 
@@ -83,11 +451,55 @@ private:
 
     static constexpr size_t ALLOC_GROW_FACTOR = 2;
 
+    // max nodes checked per bin for aligned allocations before moving to bigger bins
+    static constexpr size_t ALIGNED_SEARCH_PROBES = 16;
+
     // Bin mask types
     using top_bin_mask_t = std::conditional_t<sizeof(SizeType) <= 4, uint32_t, uint64_t>;
-    using leaf_bin_mask_t = uint8_t; // Always 8 bins per leaf
+    using leaf_bin_mask_t = std::conditional_t<
+        BINS_PER_LEAF <= 8,
+        uint8_t,
+        std::conditional_t<
+            BINS_PER_LEAF <= 16,
+            uint16_t,
+            std::conditional_t<BINS_PER_LEAF <= 32, uint32_t, uint64_t>>>;
+
+    using node_storage_t = std::conditional_t<
+        LAYOUT == MiniNodeLayout::SOA,
+        dev::mini_soa_nodes<SizeType, IndexType>,
+        dev::mini_aos_nodes<SizeType, IndexType>>;
+
+    using stats_clock = std::chrono::steady_clock;
+
+    struct no_stats {};
+    struct no_generations {};
+
+    // snapshot blob: [format][state][bin masks][bin indices][nodes][free stack]
+    struct snapshot_format {
+        uint32_t magic = 0x4D52'414D; // "MRAM"
+        uint32_t version = 2;
+        uint32_t sizeTypeBytes = sizeof(SizeType);
+        uint32_t indexTypeBytes = sizeof(IndexType);
+        uint32_t layout = static_cast<uint32_t>(LAYOUT);
+        uint32_t binsPerLeaf = static_cast<uint32_t>(BINS_PER_LEAF);
+        uint32_t generationBits = static_cast<uint32_t>(GENERATION_BITS);
+
+        constexpr bool operator==(snapshot_format const& other) const = default;
+    };
+
+    struct snapshot_state {
+        uint64_t capacity;
+        uint64_t freeStorage;
+        uint64_t nodes;
+        uint64_t freeStackPtr;
+        uint64_t headNode;
+        uint64_t tailNode;
+        uint64_t defragCursor;
+    };
 
 public:
+    using stats_type = basic_mini_stats<SizeType, NUM_LEAF_BINS>;
+
     static constexpr index_type INVALID_INDEX = invalid<IndexType>();
     static constexpr size_type NO_SPACE = invalid<SizeType>();
 
@@ -111,12 +523,35 @@ public:
      */
     [[nodiscard]] constexpr alloc_type allocate(size_type size);
 
+    /**
+     * allocates an aligned block, may fail
+     * @param size (in elements)
+     * @param alignment of the offset (in elements), power of two
+     * @return allocation (offset, id) or (NO_SPACE, NO_SPACE)
+     * @details leading padding is split off and stays free
+     */
+    [[nodiscard]] constexpr alloc_type allocate(size_type size, size_type alignment);
+
+    /**
+     * allocates a batch of blocks, reserves allocation capacity once for the whole batch
+     * @param sizes (in elements)
+     * @return allocations in order of @ref sizes, failed ones are (NO_SPACE, NO_SPACE)
+     */
+    [[nodiscard]] constexpr std::vector<alloc_type> allocate_n(std::span<size_type const> sizes);
+
     /**
      * frees an allocation
      * @param allocation to free
      */
     constexpr void free(alloc_type allocation);
 
+    /**
+     * frees a batch of allocations
+     * @param allocations to free, in any order
+     * @details neighboring allocations are coalesced into a single free block before touching the bins
+     */
+    constexpr void free_n(std::span<alloc_type const> allocations);
+
     /**
      * queries an allocation's size
      * @param allocation to check
@@ -124,6 +559,13 @@ public:
      */
     [[nodiscard]] constexpr size_type size_of(alloc_type allocation) const;
 
+    /**
+     * checks if an allocation is live, O(1)
+     * @param allocation to check
+     * @details a stale handle whose node was reused is only detected with @ref mini_config::generationBits
+     */
+    [[nodiscard]] constexpr bool valid(alloc_type allocation) const;
+
     /**
      * array of free regions in ram (count, size)
      */
@@ -140,6 +582,14 @@ public:
      */
     [[nodiscard]] constexpr defrag_type defragment() { return defragment(capacity()); }
 
+    /**
+     * incrementally defragments the ram (left compaction), continues where the last step stopped
+     * @param max_moved budget (in elements), at least one allocation is moved per step if possible
+     * @return partial report, complete is set once a full pass reached the end of the ram
+     * @details reports must be applied in order, a full @ref defragment() or @ref clear() restarts the pass
+     */
+    [[nodiscard]] constexpr defrag_step_type defragment_step(size_type max_moved);
+
     /**
      * resizes and defragments the ram
      * @param new_capacity to resize to
@@ -147,6 +597,39 @@ public:
      */
     [[nodiscard]] constexpr defrag_type resize(size_type new_capacity) { return defragment(new_capacity); }
 
+    /**
+     * resizes the ram without moving allocations
+     * @param new_capacity to resize to
+     * @return false if the cut off range is not free, the ram is unchanged in that case
+     * @details growing extends the last free block (or appends one), shrinking cuts free blocks off the end
+     */
+    constexpr bool resize_in_place(size_type new_capacity);
+
+    /**
+     * size of the @ref snapshot() blob (in bytes)
+     */
+    [[nodiscard]] size_t snapshot_size() const { return snapshotSize(nodes()); }
+
+    /**
+     * serializes the allocator state (not the stats) into a binary blob
+     * @param blob to write to, >= @ref snapshot_size()
+     * @details the blob is a plain memory image, it's only portable between identical platforms
+     */
+    void snapshot(std::span<std::byte> blob) const;
+
+    /**
+     * @copydoc snapshot(std::span<std::byte>) const
+     */
+    [[nodiscard]] std::vector<std::byte> snapshot() const;
+
+    /**
+     * restores an allocator from a @ref snapshot() blob, e.g. straight from a memory mapped file
+     * @param blob written by a ram with the same size and index types, layout, bins per leaf and generations
+     * @throws cth::except::default_exception if the blob is truncated or incompatible
+     * @details placement policy and stats don't affect the state, they may differ
+     */
+    [[nodiscard]] static basic_miniram restore(std::span<std::byte const> blob);
+
     constexpr void reserve_allocations(size_t alloc_capacity) { reserve_nodes(alloc_capacity + 1); }
 
     /**
@@ -158,6 +641,13 @@ public:
 private:
     // Float conversion functions - integrated into class
     [[nodiscard]] constexpr static size_type highest_bit(size_type number);
+    /**
+     * highest set bit of a bin mask, masks may be wider than size_type
+     */
+    template<std::unsigned_integral Mask>
+    [[nodiscard]] constexpr static size_t highest_mask_bit(Mask mask) {
+        return static_cast<size_t>(std::bit_width(mask)) - 1;
+    }
     [[nodiscard]] constexpr static size_type ceil_to_float(size_type size);
     [[nodiscard]] constexpr static size_type floor_to_float(size_type size);
     [[nodiscard]] constexpr static size_type to_uint(size_type float_value);
@@ -168,18 +658,35 @@ private:
     constexpr size_type compactUsedNodes(std::vector<index_type> const& used_nodes, defrag_type& report);
     constexpr void reconstructFreeSpace(size_type compacted_offset, index_type last_used_node);
 
+    [[nodiscard]] constexpr alloc_type allocateReserved(size_type size);
+    [[nodiscard]] constexpr size_t findUsedBin(size_t min_bin_id) const;
+    [[nodiscard]] constexpr index_type findPlacedNode(size_type size) const;
+    [[nodiscard]] constexpr index_type findInBin(size_t bin_id, size_type size) const;
+    [[nodiscard]] constexpr index_type findAlignedNode(size_type size, size_type alignment) const;
+    constexpr void releaseNodes(index_type first_node, index_type last_node, size_type size);
+
+    constexpr void swapWithHole(index_type hole_node, index_type used_node, defrag_type& report);
+    [[nodiscard]] constexpr index_type mergeFreeNodes(index_type left_node, index_type right_node);
+
     constexpr void sliceTopBinNode(
         size_type slice_size,
         size_t bin_id,
         size_t top_bin_id,
         size_t leaf_bin_id
     );
-    constexpr static size_t findLowestBitAfter(top_bin_mask_t bit_mask, size_t start_id);
+    template<class Mask>
+    constexpr static size_t findLowestBitAfter(Mask bit_mask, size_t start_id);
+    constexpr void claimNode(index_type node_index, size_type slice_size);
 
     constexpr index_type insertNode(size_type size, size_type data_offset);
+    constexpr void unlinkNode(index_type node_index);
     constexpr void removeNode(index_type node_index);
+    constexpr void linkTail(index_type node_index, index_type prev_node);
 
     [[nodiscard]] constexpr index_type newNode(size_type size);
+    [[nodiscard]] constexpr alloc_type allocOf(index_type node_index) const;
+    [[nodiscard]] constexpr index_type encodeId(index_type node_index) const;
+    [[nodiscard]] constexpr index_type nodeIdOf(alloc_type allocation) const;
     constexpr void freeNode(index_type node_index);
 
     constexpr defrag_type defragment(size_type new_size);
@@ -197,10 +704,30 @@ private:
     std::array<leaf_bin_mask_t, NUM_TOP_BINS> _usedBins{};
     std::array<index_type, NUM_LEAF_BINS> _binIndices{};
 
-    std::vector<node_type> _nodes{};
+    node_storage_t _nodes{};
     std::vector<index_type> _freeNodes{};
     size_t _freeStackPtr{};
 
+    index_type _headNode = INVALID_INDEX;
+    index_type _tailNode = INVALID_INDEX;
+    index_type _defragCursor = INVALID_INDEX;
+
+    [[no_unique_address]] std::conditional_t<GENERATIONS, std::vector<index_type>, no_generations>
+        _generations{};
+    [[no_unique_address]] std::conditional_t<STATS, stats_type, no_stats> _stats{};
+
+    [[nodiscard]] static constexpr size_t snapshotSize(size_t node_count);
+    /**
+     * checks every index and bound of a restored state
+     * @return description of the first inconsistency or nullptr
+     */
+    [[nodiscard]] char const* snapshotCorruption() const;
+
+    [[nodiscard]] constexpr alloc_type failedAlloc();
+    constexpr void recordAlloc(size_type size, size_type block_size);
+    [[nodiscard]] constexpr static stats_clock::time_point statsNow();
+    constexpr void recordDefragment(stats_clock::time_point start);
+
 public:
     /**
      * amount of elements in ram
@@ -247,6 +774,18 @@ public:
         return 1.0f - static_cast<float>(max_alloc()) / static_cast<float>(remaining());
     }
 
+    /**
+     * snapshot of the allocation statistics
+     */
+    [[nodiscard]] constexpr stats_type stats() const requires(STATS) { return _stats; }
+    /**
+     * resets the allocation statistics, the peak restarts at the current usage
+     */
+    constexpr void reset_stats() requires(STATS) {
+        _stats = stats_type{};
+        _stats.peakAllocated = allocated();
+    }
+
     constexpr basic_miniram(basic_miniram const& other) = default;
     constexpr basic_miniram(basic_miniram&& other) noexcept = default;
     constexpr basic_miniram& operator=(basic_miniram const& other) = default;
@@ -257,6 +796,14 @@ using miniram32 = basic_miniram<uint32_t, uint32_t>;
 using miniram64 = basic_miniram<uint64_t, uint32_t>;
 using miniram = basic_miniram<size_t, uint32_t>;
 
+using miniram_soa32 = basic_miniram<uint32_t, uint32_t, mini_config{.layout = MiniNodeLayout::SOA}>;
+using miniram_soa64 = basic_miniram<uint64_t, uint32_t, mini_config{.layout = MiniNodeLayout::SOA}>;
+using miniram_soa = basic_miniram<size_t, uint32_t, mini_config{.layout = MiniNodeLayout::SOA}>;
+
+using miniram_stats32 = basic_miniram<uint32_t, uint32_t, mini_config{.stats = true}>;
+using miniram_stats64 = basic_miniram<uint64_t, uint32_t, mini_config{.stats = true}>;
+using miniram_stats = basic_miniram<size_t, uint32_t, mini_config{.stats = true}>;
+
 using mini_node32 = dev::basic_mini_node<uint32_t, uint32_t>;
 using mini_node64 = dev::basic_mini_node<uint64_t, uint32_t>;
 using mini_node = dev::basic_mini_node<size_t, uint32_t>;
@@ -277,6 +824,10 @@ using mini_defrag32 = basic_mini_defrag<uint32_t, uint32_t>;
 using mini_defrag64 = basic_mini_defrag<uint64_t, uint32_t>;
 using mini_defrag = basic_mini_defrag<size_t, uint32_t>;
 
+using mini_defrag_step32 = basic_mini_defrag_step<uint32_t, uint32_t>;
+using mini_defrag_step64 = basic_mini_defrag_step<uint64_t, uint32_t>;
+using mini_defrag_step = basic_mini_defrag_step<size_t, uint32_t>;
+
 }
 
 #include "cth/data/inl/miniram.inl"
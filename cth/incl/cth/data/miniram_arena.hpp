@@ -0,0 +1,389 @@
+#pragma once
+#include "cth/constants.hpp"
+#include "cth/data/mini_mover.hpp"
+#include "cth/data/miniram.hpp"
+#include "cth/data/virtual_buffer.hpp"
+#include "cth/io/log.hpp"
+#include "cth/meta/concepts.hpp"
+
+#include <algorithm>
+#include <memory_resource>
+#include <new>
+#include <numeric>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cth::dt {
+
+struct miniram_arena_config {
+    /**
+     * reserved capacity (in elements) @ref miniram_arena::resize() can grow to, 0 means the initial capacity
+     */
+    size_t maxCapacity = 0;
+    /**
+     * initially reserved allocations, >= 1
+     */
+    size_t initialAllocCapacity = 1024;
+};
+
+/**
+ * typed arena, owns a contiguous buffer of T which is managed by a @ref miniram
+ * @details
+ * - the buffer lives in a reserved address range (@ref virtual_buffer), only the capacity is committed
+ * - @ref resize() grows in place without moving elements, shrinking decommits the freed tail
+ * - allocations are returned as RAII @ref handle, which release the block on destruction
+ * - defragmentation moves the elements (via @ref mini_mover) and patches the handles
+ * - a failing allocation defragments and retries if enough elements are free
+ * - @ref resource() adapts the arena to std::pmr, memory handed out that way is pinned,
+ *   no defragmentation happens while pinned memory is live
+ * @note spans obtained from handles are invalidated by defragmentation
+ * @note handles must not outlive the arena
+ */
+template<mta::trivial T>
+class miniram_arena {
+public:
+    using ram_type = miniram;
+    using value_type = T;
+    using size_type = ram_type::size_type;
+    using index_type = ram_type::index_type;
+    using alloc_type = ram_type::alloc_type;
+
+    static constexpr index_type INVALID_INDEX = ram_type::INVALID_INDEX;
+
+    /**
+     * alignment of the buffer (in bytes)
+     */
+    static constexpr size_t ALIGNMENT = std::max(alignof(T), CACHE_LINE_SIZE);
+    static_assert(ALIGNMENT <= virtual_buffer::MIN_PAGE_SIZE, "alignment exceeds the page alignment");
+
+    /**
+     * RAII handle of an arena allocation, releases the block on destruction
+     */
+    class handle {
+    public:
+        constexpr handle() = default;
+        ~handle() { reset(); }
+
+        /**
+         * releases the allocation, the handle is empty afterwards
+         */
+        void reset();
+
+        /**
+         * current elements of the allocation
+         * @note invalidated by defragmentation
+         */
+        [[nodiscard]] std::span<T> span() const { return {data(), _size}; }
+
+        /**
+         * current pointer to the first element
+         * @note invalidated by defragmentation
+         */
+        [[nodiscard]] T* data() const;
+
+        /**
+         * current offset (in elements) in the arena
+         */
+        [[nodiscard]] size_type offset() const;
+
+        /**
+         * size (in elements)
+         */
+        [[nodiscard]] size_type size() const { return _size; }
+        [[nodiscard]] bool empty() const { return _arena == nullptr; }
+        [[nodiscard]] explicit operator bool() const { return !empty(); }
+
+    private:
+        handle(miniram_arena* arena, index_type id, size_type size) : _arena{arena}, _id{id}, _size{size} {}
+
+        miniram_arena* _arena = nullptr;
+        index_type _id = INVALID_INDEX;
+        size_type _size = 0;
+
+        friend miniram_arena;
+
+    public:
+        handle(handle const& other) = delete;
+        handle& operator=(handle const& other) = delete;
+        handle(handle&& other) noexcept :
+            _arena{std::exchange(other._arena, nullptr)},
+            _id{std::exchange(other._id, INVALID_INDEX)},
+            _size{std::exchange(other._size, 0)} {}
+        handle& operator=(handle&& other) noexcept {
+            if(&other == this)
+                return *this;
+
+            reset();
+            _arena = std::exchange(other._arena, nullptr);
+            _id = std::exchange(other._id, INVALID_INDEX);
+            _size = std::exchange(other._size, 0);
+            return *this;
+        }
+    };
+
+    /**
+     * constructs
+     * @param capacity of the arena (in elements)
+     * @param config see @ref miniram_arena_config, e.g. {.maxCapacity = ...} for a growable arena
+     * @param mover used to execute defragmentation moves
+     */
+    explicit miniram_arena(
+        size_type capacity,
+        miniram_arena_config config = {},
+        mini_mover mover = mini_mover{}
+    );
+
+    /**
+     * allocates a block
+     * @param size (in elements)
+     * @param alignment of the block (in elements), power of two
+     * @return handle or empty handle if the arena is out of space
+     */
+    [[nodiscard]] handle allocate(size_type size, size_type alignment = 1);
+
+    /**
+     * defragments the arena, moves the elements and patches the handles
+     * @return false if pinned memory prevented the defragmentation
+     */
+    bool defragment();
+
+    /**
+     * incrementally defragments the arena, moves the elements and patches the handles
+     * @param max_moved budget (in elements), see @ref basic_miniram::defragment_step()
+     * @return true once a full pass is complete, false if more steps are needed or pinned memory is live
+     */
+    bool defragment_step(size_type max_moved);
+
+    /**
+     * resizes the arena within @ref max_capacity()
+     * @param new_capacity (in elements)
+     * @return false if the capacity is exceeded, or shrinking needs compaction which isn't possible
+     * @details
+     * - growing commits memory and extends the last free block, no elements are moved
+     * - shrinking cuts free blocks off the end and decommits them, defragments if the tail is in use
+     */
+    bool resize(size_type new_capacity);
+
+    /**
+     * std::pmr adapter, memory allocated through it is pinned
+     */
+    [[nodiscard]] std::pmr::memory_resource* resource() { return &_resource; }
+
+private:
+    class pmr_resource : public std::pmr::memory_resource {
+    public:
+        explicit pmr_resource(miniram_arena& arena) : _arena{&arena} {}
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+        [[nodiscard]] bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+            return this == &other;
+        }
+
+        miniram_arena* _arena;
+    };
+
+    [[nodiscard]] alloc_type allocateBlock(size_type size, size_type alignment);
+    void release(index_type id);
+    void apply(typename ram_type::defrag_type const& report);
+
+    ram_type _ram;
+    mini_mover _mover;
+    virtual_buffer _buffer;
+
+    std::vector<size_type> _offsets{};
+    std::unordered_map<size_type, index_type> _pinned{};
+
+    pmr_resource _resource{*this};
+
+public:
+    /**
+     * buffer of the arena
+     */
+    [[nodiscard]] T* data() const { return reinterpret_cast<T*>(_buffer.data()); }
+    /**
+     * amount of elements in the arena
+     */
+    [[nodiscard]] size_type capacity() const { return _ram.capacity(); }
+    /**
+     * max amount of elements the arena can grow to, the reserved range is rounded up to pages
+     */
+    [[nodiscard]] size_type max_capacity() const {
+        return static_cast<size_type>(_buffer.reserved() / sizeof(T));
+    }
+    /**
+     * amount of unallocated elements left in the arena
+     */
+    [[nodiscard]] size_type remaining() const { return _ram.remaining(); }
+    /**
+     * amount of allocated elements in the arena
+     */
+    [[nodiscard]] size_type allocated() const { return _ram.allocated(); }
+    /**
+     * rates the fragmentation [0, 1] (good to bad)
+     */
+    [[nodiscard]] float fragmentation() const { return _ram.fragmentation(); }
+    /**
+     * true if memory allocated through @ref resource() is live
+     */
+    [[nodiscard]] bool pinned() const { return !_pinned.empty(); }
+
+    miniram_arena(miniram_arena const& other) = delete;
+    miniram_arena(miniram_arena&& other) = delete;
+    miniram_arena& operator=(miniram_arena const& other) = delete;
+    miniram_arena& operator=(miniram_arena&& other) = delete;
+};
+
+}
+
+namespace cth::dt {
+
+template<mta::trivial T>
+miniram_arena<T>::miniram_arena(size_type capacity, miniram_arena_config config, mini_mover mover) :
+    _ram{capacity, config.initialAllocCapacity},
+    _mover{std::move(mover)},
+    _buffer{std::max<size_t>(capacity, config.maxCapacity) * sizeof(T)} {
+    _buffer.commit(capacity * sizeof(T));
+}
+
+template<mta::trivial T>
+auto miniram_arena<T>::allocate(size_type size, size_type alignment) -> handle {
+    auto const alloc = allocateBlock(size, alignment);
+    if(alloc.id == INVALID_INDEX)
+        return handle{};
+
+    if(alloc.id >= _offsets.size())
+        _offsets.resize(std::max<size_t>(alloc.id + 1, _offsets.size() * 2));
+
+    _offsets[alloc.id] = alloc.offset;
+
+    return handle{this, alloc.id, size};
+}
+
+template<mta::trivial T>
+bool miniram_arena<T>::defragment() {
+    if(pinned())
+        return false;
+
+    apply(_ram.defragment());
+    return true;
+}
+
+template<mta::trivial T>
+bool miniram_arena<T>::defragment_step(size_type max_moved) {
+    if(pinned())
+        return false;
+
+    auto const step = _ram.defragment_step(max_moved);
+    apply(step.report);
+
+    return step.complete;
+}
+
+template<mta::trivial T>
+bool miniram_arena<T>::resize(size_type new_capacity) {
+    if(new_capacity > max_capacity())
+        return false;
+
+    if(new_capacity >= capacity()) {
+        _buffer.commit(new_capacity * sizeof(T));
+        return _ram.resize_in_place(new_capacity);
+    }
+
+    if(!_ram.resize_in_place(new_capacity)) {
+        if(new_capacity < allocated() || pinned())
+            return false;
+
+        apply(_ram.resize(new_capacity));
+    }
+
+    _buffer.decommit(new_capacity * sizeof(T));
+    return true;
+}
+
+template<mta::trivial T>
+auto miniram_arena<T>::allocateBlock(size_type size, size_type alignment) -> alloc_type {
+    auto alloc = _ram.allocate(size, alignment);
+
+    // compaction can only help if enough elements are free
+    if(alloc.id == INVALID_INDEX && size <= remaining() && defragment())
+        alloc = _ram.allocate(size, alignment);
+
+    return alloc;
+}
+
+template<mta::trivial T>
+void miniram_arena<T>::release(index_type id) {
+    _ram.free({.offset = _offsets[id], .id = id});
+}
+
+template<mta::trivial T>
+void miniram_arena<T>::apply(typename ram_type::defrag_type const& report) {
+    _mover.execute(report, data(), sizeof(T));
+
+    for(auto const& alloc : report.updatedAllocs)
+        _offsets[alloc.id] = alloc.offset;
+}
+
+template<mta::trivial T>
+void miniram_arena<T>::handle::reset() {
+    if(_arena == nullptr)
+        return;
+
+    _arena->release(_id);
+
+    _arena = nullptr;
+    _id = INVALID_INDEX;
+    _size = 0;
+}
+
+template<mta::trivial T>
+T* miniram_arena<T>::handle::data() const {
+    if(_arena == nullptr)
+        return nullptr;
+
+    return _arena->data() + _arena->_offsets[_id];
+}
+
+template<mta::trivial T>
+auto miniram_arena<T>::handle::offset() const -> size_type {
+    if(_arena == nullptr)
+        return ram_type::NO_SPACE;
+
+    return _arena->_offsets[_id];
+}
+
+template<mta::trivial T>
+void* miniram_arena<T>::pmr_resource::do_allocate(size_t bytes, size_t alignment) {
+    if(alignment > ALIGNMENT)
+        throw std::bad_alloc{};
+
+    auto const size = std::max<size_t>((bytes + sizeof(T) - 1) / sizeof(T), 1);
+    // offset * sizeof(T) has to be a multiple of alignment
+    auto const elementAlignment = alignment / std::gcd(alignment, sizeof(T));
+
+    auto const alloc =
+        _arena->allocateBlock(static_cast<size_type>(size), static_cast<size_type>(elementAlignment));
+    if(alloc.id == INVALID_INDEX)
+        throw std::bad_alloc{};
+
+    _arena->_pinned.emplace(alloc.offset, alloc.id);
+
+    return _arena->data() + alloc.offset;
+}
+
+template<mta::trivial T>
+void miniram_arena<T>::pmr_resource::do_deallocate(void* ptr, size_t, size_t) {
+    auto const offset = static_cast<size_type>(static_cast<T*>(ptr) - _arena->data());
+
+    auto const it = _arena->_pinned.find(offset);
+    CTH_CRITICAL(it == _arena->_pinned.end(), "pointer was not allocated by this resource") {}
+
+    _arena->_ram.free({.offset = offset, .id = it->second});
+    _arena->_pinned.erase(it);
+}
+
+}
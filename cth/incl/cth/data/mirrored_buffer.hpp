@@ -0,0 +1,219 @@
+#pragma once
+#include "cth/io/log.hpp"
+#include "cth/os/osdef.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#ifdef CTH_PLATFORM_WINDOWS
+// the header is public, min / max macros would break std::max and numeric_limits<>::max in includers
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <atomic>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cth::dt {
+
+/**
+ * byte buffer mapped twice back to back ("magic ring buffer")
+ * @details
+ * - [data(), data() + size()) and [data() + size(), data() + 2 * size()) are the same physical memory
+ * - a range starting inside the first mapping is contiguous for up to size() bytes, it never has to wrap
+ * - use with @ref RingWrap::MIRRORED ring allocators
+ */
+class mirrored_buffer {
+public:
+    mirrored_buffer() = default;
+
+    /**
+     * maps the buffer
+     * @param bytes size of the buffer, rounded up to @ref granularity()
+     * @throws cth::except::default_exception if the mapping fails
+     */
+    explicit mirrored_buffer(size_t bytes);
+    ~mirrored_buffer() { release(); }
+
+    /**
+     * size granularity in bytes, the page size (allocation granularity on windows)
+     */
+    [[nodiscard]] static size_t granularity();
+
+private:
+    /**
+     * maps both views
+     * @return base of the first view or nullptr on failure, no resources are held on failure
+     */
+    [[nodiscard]] static std::byte* mapMirrored(size_t size);
+    void release();
+
+    std::byte* _data = nullptr;
+    size_t _size = 0;
+
+public:
+    [[nodiscard]] std::byte* data() const { return _data; }
+    /**
+     * size of the buffer in bytes, the mapped range is twice as big
+     */
+    [[nodiscard]] size_t size() const { return _size; }
+
+    mirrored_buffer(mirrored_buffer const& other) = delete;
+    mirrored_buffer& operator=(mirrored_buffer const& other) = delete;
+    mirrored_buffer(mirrored_buffer&& other) noexcept :
+        _data{std::exchange(other._data, nullptr)},
+        _size{std::exchange(other._size, 0)} {}
+    mirrored_buffer& operator=(mirrored_buffer&& other) noexcept {
+        if(&other == this)
+            return *this;
+
+        release();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+        return *this;
+    }
+};
+
+}
+
+namespace cth::dt {
+
+inline mirrored_buffer::mirrored_buffer(size_t bytes) {
+    auto const unit = granularity();
+    auto const size = (bytes + unit - 1) / unit * unit;
+    if(size == 0)
+        return;
+
+    auto* const data = mapMirrored(size);
+
+    CTH_STABLE_ERR(data == nullptr, "failed to map mirrored buffer") {
+        details->add("bytes: {}", size);
+        throw details->exception();
+    }
+
+    _data = data;
+    _size = size;
+}
+
+inline size_t mirrored_buffer::granularity() {
+#ifdef CTH_PLATFORM_WINDOWS
+    // views must start on allocation granularity boundaries, not just pages
+    static size_t const granularity = [] {
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwAllocationGranularity);
+    }();
+#else
+    static size_t const granularity = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    return granularity;
+}
+
+inline std::byte* mirrored_buffer::mapMirrored(size_t size) {
+#ifdef CTH_PLATFORM_WINDOWS
+    auto const bytes = static_cast<uint64_t>(size);
+    HANDLE const mapping = CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        nullptr,
+        PAGE_READWRITE,
+        static_cast<DWORD>(bytes >> 32),
+        static_cast<DWORD>(bytes),
+        nullptr
+    );
+    if(mapping == nullptr)
+        return nullptr;
+
+    constexpr size_t maxAttempts = 16;
+    std::byte* result = nullptr;
+
+    // the probed range is released before mapping, another thread may take it in between => retry
+    for(size_t attempt = 0; attempt < maxAttempts && result == nullptr; ++attempt) {
+        void* const probe = VirtualAlloc(nullptr, 2 * size, MEM_RESERVE, PAGE_NOACCESS);
+        if(probe == nullptr)
+            break;
+        VirtualFree(probe, 0, MEM_RELEASE);
+
+        auto* const first = static_cast<std::byte*>(
+            MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, probe)
+        );
+        if(first == nullptr)
+            continue;
+
+        if(MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, first + size) == nullptr) {
+            UnmapViewOfFile(first);
+            continue;
+        }
+
+        result = first;
+    }
+
+    // the views keep the mapping alive
+    CloseHandle(mapping);
+    return result;
+#else
+#ifdef CTH_PLATFORM_LINUX
+    int const fd = memfd_create("cth_mirrored_buffer", MFD_CLOEXEC);
+#else
+    // no memfd, anonymous shared memory via a name that is unlinked right away
+    static std::atomic<size_t> nextId{0};
+    auto const name = "/cth_mirror_" + std::to_string(getpid()) + "_"
+        + std::to_string(nextId.fetch_add(1, std::memory_order::relaxed));
+
+    int const fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if(fd != -1)
+        shm_unlink(name.c_str());
+#endif
+    if(fd == -1)
+        return nullptr;
+
+    std::byte* result = nullptr;
+
+    if(ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        // reserve both halves first, the fixed mappings replace the reservation
+        void* const range =
+            mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+        if(range != MAP_FAILED) {
+            auto* const first = static_cast<std::byte*>(range);
+            auto const mapView = [fd, size](std::byte* at) {
+                return mmap(at, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+            };
+
+            if(mapView(first) && mapView(first + size))
+                result = first;
+            else
+                munmap(range, 2 * size);
+        }
+    }
+
+    // the mappings keep the memory alive
+    close(fd);
+    return result;
+#endif
+}
+
+inline void mirrored_buffer::release() {
+    if(_data == nullptr)
+        return;
+
+#ifdef CTH_PLATFORM_WINDOWS
+    UnmapViewOfFile(_data + _size);
+    UnmapViewOfFile(_data);
+#else
+    munmap(_data, 2 * _size);
+#endif
+
+    _data = nullptr;
+    _size = 0;
+}
+
+}
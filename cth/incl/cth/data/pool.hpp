@@ -1,34 +1,171 @@
 #pragma once
+#include "cth/constants.hpp"
 #include "cth/io/log.hpp"
 #include "cth/meta/concepts.hpp"
 
-#include <deque>
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <new>
 #include <ranges>
-#include <unordered_set>
+#include <span>
+#include <utility>
 #include <vector>
 
 namespace cth::dt {
 
 struct basic_pool_manipulator {};
 
+/**
+ * RAII handle of an acquired pool resource, releases it back into its pool on destruction
+ * @details works with every pool that has void release(T&), the pool must outlive the lease
+ */
+template<class T>
+class lease {
+public:
+    lease() = default;
+
+    /**
+     * takes over an acquired resource
+     * @param value acquired from @ref owner
+     * @param owner to release into
+     */
+    template<class Pool>
+    lease(T& value, Pool& owner) :
+        _value{std::addressof(value)},
+        _owner{std::addressof(owner)},
+        _release{[](void* pool, T& t) { static_cast<Pool*>(pool)->release(t); }} {}
+
+    ~lease() { reset(); }
+
+    /**
+     * releases the resource early
+     * @post empty
+     */
+    void reset() {
+        if(_value == nullptr)
+            return;
+
+        _release(_owner, *std::exchange(_value, nullptr));
+    }
+
+private:
+    T* _value = nullptr;
+    void* _owner = nullptr;
+    void (*_release)(void*, T&) = nullptr;
+
+public:
+    [[nodiscard]] T* get() const { return _value; }
+    [[nodiscard]] T& operator*() const { return *_value; }
+    [[nodiscard]] T* operator->() const { return _value; }
+    [[nodiscard]] explicit operator bool() const { return _value != nullptr; }
+
+    lease(lease const& other) = delete;
+    lease& operator=(lease const& other) = delete;
+    lease(lease&& other) noexcept :
+        _value{std::exchange(other._value, nullptr)},
+        _owner{other._owner},
+        _release{other._release} {}
+    lease& operator=(lease&& other) noexcept {
+        if(&other == this)
+            return *this;
+
+        reset();
+        _value = std::exchange(other._value, nullptr);
+        _owner = other._owner;
+        _release = other._release;
+        return *this;
+    }
+};
+
 /**
  * generic reusable resource pool
+ * @details
+ * - every slot stores its acquired state and the intrusive free list link next to the instance
+ * - @ref acquire(), @ref release() and double release detection are O(1)
+ * - slots live in cache line aligned chunks of @ref chunk_size() slots, sweeps walk contiguous memory
+ * - instances never move, @ref acquire_lease() hands them out as RAII @ref lease
  * @tparam T to pool
  * @tparam Manipulator may implement void reset(T&) to reset released instances
+ * @tparam Validate debug builds also check that released instances belong to the pool, O(n) per release
  */
-template<class T, class Manipulator = basic_pool_manipulator>
+template<class T, class Manipulator = basic_pool_manipulator, bool Validate = false>
 class pool {
-    using storage_type = std::deque<T>;
+    struct slot {
+        template<class... CArgs>
+        explicit slot(std::in_place_t, CArgs&&... args) : value(std::forward<CArgs>(args)...) {}
+
+        // first member, the address of a value is the address of its slot
+        T value;
+        slot* next = nullptr;
+        bool acquired = false;
+    };
+
+    static constexpr auto CHUNK_ALIGNMENT = std::align_val_t{std::max(alignof(slot), CACHE_LINE_SIZE)};
+
+    /**
+     * fixed capacity slot array, constructed front to back
+     */
+    class chunk {
+        struct chunk_delete {
+            void operator()(slot* ptr) const { ::operator delete(ptr, CHUNK_ALIGNMENT); }
+        };
+
+    public:
+        explicit chunk(size_t capacity) :
+            _data{static_cast<slot*>(::operator new(capacity * sizeof(slot), CHUNK_ALIGNMENT))},
+            _capacity{capacity} {}
+        ~chunk() {
+            for(auto& s : slots())
+                s.~slot();
+        }
+
+        template<class... CArgs>
+        slot& emplace(CArgs&&... args) {
+            auto* const created =
+                ::new(static_cast<void*>(_data.get() + _size)) slot{std::forward<CArgs>(args)...};
+            ++_size;
+            return *created;
+        }
+
+    private:
+        std::unique_ptr<slot, chunk_delete> _data;
+        size_t _capacity;
+        size_t _size = 0;
+
+    public:
+        [[nodiscard]] std::span<slot> slots() const { return {_data.get(), _size}; }
+        [[nodiscard]] bool full() const { return _size == _capacity; }
+
+        chunk(chunk const& other) = delete;
+        chunk& operator=(chunk const& other) = delete;
+        chunk(chunk&& other) noexcept :
+            _data{std::move(other._data)},
+            _capacity{other._capacity},
+            _size{std::exchange(other._size, 0)} {}
+        chunk& operator=(chunk&& other) = delete;
+    };
 
 public:
     static constexpr bool HAS_RESET = requires(Manipulator m, T& t) {
         { m.reset(t) } -> mta::is_void;
     };
+    static constexpr bool VALIDATE = Validate;
+    /**
+     * slots per chunk, about a page
+     */
+    static constexpr size_t DEFAULT_CHUNK_SIZE = std::max<size_t>(4096 / sizeof(slot), 16);
     using value_type = T;
 
-    explicit pool(Manipulator manipulator = {}) : _manipulator{std::move(manipulator)} {}
+    explicit pool(Manipulator manipulator = {}) : pool{DEFAULT_CHUNK_SIZE, std::move(manipulator)} {}
+
+    /**
+     * @param chunk_size slots per chunk, >= 1
+     * @param manipulator see @ref Manipulator
+     */
+    explicit pool(size_t chunk_size, Manipulator manipulator = {}) :
+        _manipulator{std::move(manipulator)},
+        _chunkSize{std::max<size_t>(chunk_size, 1)} {}
 
     /**
      * constructs an instance of T in the pool
@@ -37,26 +174,22 @@ public:
      */
     template<class... CArgs> requires std::constructible_from<T, CArgs...>
     void emplace(CArgs&&... args) {
-        _storage.emplace_back(std::forward<CArgs>(args)...);
-        _inactive.emplace_back(&_storage.back());
+        if(_chunks.empty() || _chunks.back().full())
+            _chunks.emplace_back(_chunkSize);
+
+        pushFree(_chunks.back().emplace(std::in_place, std::forward<CArgs>(args)...));
+        ++_capacity;
     }
 
     /**
-     * forwards range to storage
+     * constructs an instance of T from every element of the range
      * @post pools capacity increases by size of @ref Rng
      */
-    template<class Rng> requires requires(Rng r, storage_type s) { s.append_range(std::forward<Rng>(r)); }
+    template<std::ranges::input_range Rng>
+        requires std::constructible_from<T, std::ranges::range_reference_t<Rng>>
     void append_range(Rng&& rng) {
-        size_t oldSize = _storage.size();
-
-        _storage.append_range(std::forward<Rng>(rng));
-
-        auto pointers = std::views::transform(
-            std::ranges::subrange{_storage.begin() + oldSize, _storage.end()},
-            [](auto& obj) { return std::addressof(obj); }
-        );
-
-        _inactive.append_range(pointers);
+        for(auto&& element : rng)
+            emplace(std::forward<decltype(element)>(element));
     }
 
     /**
@@ -65,33 +198,37 @@ public:
      * @post resource will not be acquired again until @ref release(T&) is called with this instance
      */
     [[nodiscard]] T& acquire() {
-        CTH_CRITICAL(_inactive.empty(), "pool exhausted") {}
+        CTH_CRITICAL(exhausted(), "pool exhausted") {}
 
-        auto& back = *_inactive.back();
-        _inactive.pop_back();
-        return back;
+        auto& front = *std::exchange(_free, _free->next);
+        front.acquired = true;
+        --_remaining;
+
+        return front.value;
     }
 
+    /**
+     * acquires a resource as @ref lease, released when the lease is destroyed
+     * @pre must not be @ref exhausted()
+     */
+    [[nodiscard]] lease<T> acquire_lease() { return lease<T>{acquire(), *this}; }
+
     /**
      * @pre @ref t was acquired, not already released and the pool not cleared
      * @post @ref t is reset and can be acquired again
      */
     void release(T& t) {
-        auto const ptr = std::addressof(t);
+        if constexpr(VALIDATE) {
+            CTH_CRITICAL(!owns(t), "unknown resource released") {}
+        }
 
-        CTH_CRITICAL(std::ranges::contains(_inactive, ptr), "a resource must not be released twice") {}
-        CTH_CRITICAL(
-            !std::ranges::contains(
-                _storage | std::views::transform([](auto& e) { return std::addressof(e); }),
-                ptr
-            ),
-            "unknown resource released"
-        ) {}
+        auto& released = slotOf(t);
+        CTH_CRITICAL(!released.acquired, "a resource must not be released twice") {}
 
         if constexpr(HAS_RESET)
             _manipulator.reset(t);
 
-        _inactive.push_back(ptr);
+        pushFree(released);
     }
 
     /**
@@ -99,46 +236,91 @@ public:
      * @pre calling release on a resource which was acquired before clear is UB
      */
     void clear() {
-        resetActive();
-
-        _inactive.clear();
-        _inactive.append_range(
-            _storage | std::views::transform(
-                [](auto& element) { return std::addressof(element); }
-            )
-        );
+        _free = nullptr;
+        _remaining = 0;
+
+        for(auto const& c : _chunks)
+            for(auto& stored : c.slots()) {
+                if constexpr(HAS_RESET)
+                    if(stored.acquired)
+                        _manipulator.reset(stored.value);
+
+                pushFree(stored);
+            }
+    }
+
+    /**
+     * checks if the instance belongs to the pool, O(chunks)
+     */
+    [[nodiscard]] bool owns(T const& t) const {
+        auto const* const ptr = reinterpret_cast<slot const*>(std::addressof(t));
+
+        return std::ranges::any_of(_chunks, [ptr](chunk const& c) {
+            auto const slots = c.slots();
+            // pointers into different arrays are only ordered by std::less
+            return !std::less{}(ptr, slots.data()) && std::less{}(ptr, slots.data() + slots.size());
+        });
     }
 
 private:
-    void resetActive() {
-        if constexpr(HAS_RESET) {
-            std::unordered_set inactiveSet{std::from_range, _inactive};
+    [[nodiscard]] static slot& slotOf(T& t) { return *reinterpret_cast<slot*>(std::addressof(t)); }
 
-            for(auto& stored : _storage)
-                if(!inactiveSet.contains(&stored))
-                    _manipulator.reset(stored);
-        }
+    void pushFree(slot& s) {
+        s.acquired = false;
+        s.next = std::exchange(_free, &s);
+        ++_remaining;
     }
 
     Manipulator _manipulator;
+    size_t _chunkSize;
 
-    std::vector<T*> _inactive{};
-    std::deque<T> _storage{};
+    std::vector<chunk> _chunks{};
+    slot* _free = nullptr;
+    size_t _remaining = 0;
+    size_t _capacity = 0;
 
 public:
     /**
      * total number of instances in pool
      */
-    [[nodiscard]] size_t capacity() const noexcept { return _storage.size(); }
+    [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+
+    /**
+     * slots per chunk
+     */
+    [[nodiscard]] size_t chunk_size() const noexcept { return _chunkSize; }
 
     /**
      * remaining instances to acquire without releasing
      */
-    [[nodiscard]] size_t remaining() const noexcept { return _inactive.size(); }
+    [[nodiscard]] size_t remaining() const noexcept { return _remaining; }
 
     /**
      * true if no more acquire calls are possible
      */
-    [[nodiscard]] bool exhausted() const noexcept { return _inactive.empty(); }
+    [[nodiscard]] bool exhausted() const noexcept { return _free == nullptr; }
+
+    // the free list and leases point into the chunks, moving the pool keeps the slots in place
+    pool(pool const& other) = delete;
+    pool& operator=(pool const& other) = delete;
+    pool(pool&& other) noexcept :
+        _manipulator{std::move(other._manipulator)},
+        _chunkSize{other._chunkSize},
+        _chunks{std::move(other._chunks)},
+        _free{std::exchange(other._free, nullptr)},
+        _remaining{std::exchange(other._remaining, 0)},
+        _capacity{std::exchange(other._capacity, 0)} {}
+    pool& operator=(pool&& other) noexcept {
+        if(&other == this)
+            return *this;
+
+        _manipulator = std::move(other._manipulator);
+        _chunkSize = other._chunkSize;
+        _chunks = std::move(other._chunks);
+        _free = std::exchange(other._free, nullptr);
+        _remaining = std::exchange(other._remaining, 0);
+        _capacity = std::exchange(other._capacity, 0);
+        return *this;
+    }
 };
 }
@@ -0,0 +1,154 @@
+#pragma once
+#include "cth/constants.hpp"
+#include "cth/data/mirrored_buffer.hpp"
+#include "cth/data/ringalloc.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <utility>
+
+namespace cth::dt {
+
+struct ring_buffer_config {
+    /**
+     * rounds every allocation up to whole cache lines
+     */
+    bool padCacheLines = false;
+    /**
+     * @ref RingWrap::MIRRORED maps the buffer twice, allocations never wrap and waste no padding
+     * @note the size is rounded up to @ref mirrored_buffer::granularity()
+     */
+    RingWrap wrap = RingWrap::PAD;
+};
+
+/**
+ * memory owning ring buffer, hands out spans of a cache line aligned byte buffer
+ * @details
+ * - the space is managed by the ring allocator, its free order rules apply
+ * - with cache line padding every allocation starts on its own cache line and no two allocations share one
+ * - with @ref RingWrap::MIRRORED spans may run past the end into the mirror mapping
+ * @tparam Alloc @ref ring_alloc (cumulative free) or @ref completion_ring_alloc (any order)
+ */
+template<class Alloc = ring_alloc>
+class basic_ring_buffer {
+public:
+    using alloc_type = Alloc;
+
+    static constexpr size_t ALIGNMENT = CACHE_LINE_SIZE;
+
+    struct allocation {
+        std::span<std::byte> data;
+        cleanup_t cleanup;
+    };
+
+    /**
+     * creates the ring buffer
+     * @param size in bytes, rounded up to a multiple of @ref ALIGNMENT if padded
+     * @param config see @ref ring_buffer_config
+     * @param alloc_args forwarded to the allocator constructor after size and wrap mode
+     * @throws cth::except::default_exception if the mirrored buffer can't be mapped
+     */
+    template<class... AllocArgs>
+    explicit basic_ring_buffer(size_t size, ring_buffer_config config = {}, AllocArgs&&... alloc_args);
+
+    /**
+     * allocates
+     * @param size in bytes
+     * @return span of exactly size bytes or empty if not enough space
+     */
+    [[nodiscard]] std::optional<allocation> alloc(size_t size);
+
+    /**
+     * frees the allocation, see the allocator for the free order
+     * @param token to free
+     */
+    void free(cleanup_t token) { _alloc.free(token); }
+
+private:
+    [[nodiscard]] static constexpr size_t padSize(size_t size) {
+        return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+    [[nodiscard]] static size_t ringSize(size_t size, ring_buffer_config config);
+
+    struct aligned_delete {
+        void operator()(std::byte* ptr) const { ::operator delete[](ptr, std::align_val_t{ALIGNMENT}); }
+    };
+
+    ring_buffer_config _config;
+    std::unique_ptr<std::byte[], aligned_delete> _buffer;
+    mirrored_buffer _mirror;
+    Alloc _alloc;
+
+public:
+    [[nodiscard]] std::byte* data() const { return _buffer ? _buffer.get() : _mirror.data(); }
+    [[nodiscard]] size_t size() const { return _alloc.size(); }
+    /**
+     * alias for size
+     */
+    [[nodiscard]] size_t capacity() const { return size(); }
+    /**
+     * true if allocations are padded to cache lines
+     */
+    [[nodiscard]] bool padded() const { return _config.padCacheLines; }
+    [[nodiscard]] RingWrap wrap() const { return _config.wrap; }
+    /**
+     * allocated bytes, including padding
+     */
+    [[nodiscard]] size_t allocated() const { return _alloc.allocated(); }
+    /**
+     * gets the current max allocation size
+     * @return size in bytes
+     * @note in highly threaded environments this may not be accurate
+     */
+    [[nodiscard]] size_t max_alloc() const { return _alloc.max_alloc(); }
+    [[nodiscard]] Alloc const& allocator() const { return _alloc; }
+};
+
+using ring_buffer = basic_ring_buffer<ring_alloc>;
+using completion_ring_buffer = basic_ring_buffer<completion_ring_alloc>;
+
+}
+
+namespace cth::dt {
+
+template<class Alloc>
+template<class... AllocArgs>
+basic_ring_buffer<Alloc>::basic_ring_buffer(
+    size_t size,
+    ring_buffer_config config,
+    AllocArgs&&... alloc_args
+) :
+    _config{config},
+    _buffer{
+        config.wrap == RingWrap::PAD
+            ? static_cast<std::byte*>(::operator new[](padSize(size), std::align_val_t{ALIGNMENT}))
+            : nullptr
+    },
+    _mirror{config.wrap == RingWrap::MIRRORED ? mirrored_buffer{size} : mirrored_buffer{}},
+    _alloc(ringSize(size, config), config.wrap, std::forward<AllocArgs>(alloc_args)...) {}
+
+template<class Alloc>
+auto basic_ring_buffer<Alloc>::alloc(size_t size) -> std::optional<allocation> {
+    // the ring size is a multiple of the alignment when padded, so every begin stays aligned across wraps
+    auto const result = _alloc.alloc(padded() ? padSize(size) : size);
+    if(!result)
+        return std::nullopt;
+
+    return allocation{{data() + result->begin, size}, result->cleanup};
+}
+
+template<class Alloc>
+size_t basic_ring_buffer<Alloc>::ringSize(size_t size, ring_buffer_config config) {
+    // the granularity is a multiple of the cache line size, padded begins stay aligned as well
+    if(config.wrap == RingWrap::MIRRORED) {
+        auto const unit = mirrored_buffer::granularity();
+        return (size + unit - 1) / unit * unit;
+    }
+
+    return config.padCacheLines ? padSize(size) : size;
+}
+
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include "cth/constants.hpp"
+#include "cth/data/mirrored_buffer.hpp"
+#include "cth/data/ringalloc.hpp"
+#include "cth/io/log.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <span>
+
+namespace cth::dt {
+
+enum class RingProducers : uint8_t {
+    /**
+     * allocates without CAS, publishes all written records with one position store
+     */
+    SINGLE,
+    /**
+     * publishes every record via its header, consumed space is zeroed so headers read as unpublished
+     */
+    MULTI,
+};
+
+enum class RingConsumers : uint8_t {
+    SINGLE,
+    /**
+     * drains are serialized, a batch goes to one consumer at a time
+     */
+    MULTI,
+};
+
+/**
+ * variable length message queue of length prefixed records in a @ref ring_alloc managed mirrored buffer
+ * @details
+ * - record layout: [length + 1:4][unused:4][payload][padding to @ref RECORD_ALIGNMENT]
+ * - the buffer is mapped twice (@ref mirrored_buffer), payloads are contiguous and never wrap
+ * - records are published with release semantics, consumers only see completely written records
+ * - consumers read records in place (zero copy) and free them in batches
+ * @tparam Producers concurrent producers, see @ref RingProducers
+ * @tparam Consumers concurrent consumers, see @ref RingConsumers
+ */
+template<RingProducers Producers = RingProducers::MULTI, RingConsumers Consumers = RingConsumers::SINGLE>
+class basic_ring_queue {
+public:
+    static constexpr size_t HEADER_SIZE = 8;
+    static constexpr size_t RECORD_ALIGNMENT = 8;
+
+    /**
+     * creates the queue
+     * @param size in bytes, rounded up to @ref mirrored_buffer::granularity()
+     * @throws cth::except::default_exception if the buffer can't be mapped
+     */
+    explicit basic_ring_queue(size_t size);
+
+    /**
+     * writes a record in place
+     * @param size of the payload in bytes
+     * @param write called with the payload span (std::span<std::byte>), must fill it
+     * @return false if not enough space
+     */
+    template<class Fn>
+    [[nodiscard]] bool try_emplace(size_t size, Fn&& write);
+
+    /**
+     * copies a record into the queue
+     * @param payload to copy
+     * @return false if not enough space
+     */
+    [[nodiscard]] bool try_push(std::span<std::byte const> payload) {
+        return try_emplace(payload.size(), [payload](std::span<std::byte> record) {
+            std::ranges::copy(payload, record.begin());
+        });
+    }
+
+    /**
+     * reads published records in order and frees them as one batch
+     * @param read called with every payload (std::span<std::byte const>), spans are valid until drain returns
+     * @param max_records to read
+     * @return amount of read records
+     */
+    template<class Fn>
+    size_t drain(Fn&& read, size_t max_records = std::numeric_limits<size_t>::max());
+
+private:
+    template<class Fn>
+    size_t drainRecords(Fn& read, size_t max_records);
+
+    [[nodiscard]] static constexpr size_t recordSize(size_t payload) {
+        return (HEADER_SIZE + payload + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+    }
+    [[nodiscard]] std::byte* at(size_t position) const { return _buffer.data() + position % _buffer.size(); }
+
+    static constexpr uint32_t UNPUBLISHED = 0;
+
+    mirrored_buffer _buffer;
+    ring_alloc _alloc;
+
+    // single producer, end of the published records
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _published{};
+
+    // consumer owned
+    alignas(CACHE_LINE_SIZE) size_t _readPos = 0;
+    std::mutex _consumerMutex{};
+
+public:
+    [[nodiscard]] size_t size() const { return _buffer.size(); }
+    /**
+     * allocated bytes, including headers and padding of unread records
+     * @note snapshot, may be outdated immediately in threaded environments
+     */
+    [[nodiscard]] size_t allocated() const { return _alloc.allocated(); }
+    /**
+     * largest payload that fits into the empty queue
+     */
+    [[nodiscard]] size_t max_record_size() const { return size() - HEADER_SIZE; }
+
+    basic_ring_queue(basic_ring_queue const& other) = delete;
+    basic_ring_queue(basic_ring_queue&& other) = delete;
+    basic_ring_queue& operator=(basic_ring_queue const& other) = delete;
+    basic_ring_queue& operator=(basic_ring_queue&& other) = delete;
+};
+
+using spsc_ring_queue = basic_ring_queue<RingProducers::SINGLE, RingConsumers::SINGLE>;
+using mpsc_ring_queue = basic_ring_queue<RingProducers::MULTI, RingConsumers::SINGLE>;
+using mpmc_ring_queue = basic_ring_queue<RingProducers::MULTI, RingConsumers::MULTI>;
+
+}
+
+namespace cth::dt {
+
+template<RingProducers Producers, RingConsumers Consumers>
+basic_ring_queue<Producers, Consumers>::basic_ring_queue(size_t size) :
+    _buffer{size},
+    _alloc{_buffer.size(), RingWrap::MIRRORED} {}
+
+template<RingProducers Producers, RingConsumers Consumers>
+template<class Fn>
+bool basic_ring_queue<Producers, Consumers>::try_emplace(size_t size, Fn&& write) {
+    CTH_CRITICAL(size >= std::numeric_limits<uint32_t>::max(), "record too big for the length header") {}
+
+    auto const total = recordSize(size);
+
+    auto const allocation = Producers == RingProducers::SINGLE ? _alloc.alloc_exclusive(total)
+                                                               : _alloc.alloc(total);
+    if(!allocation)
+        return false;
+
+    // totals are multiples of the alignment and the buffer is page aligned, headers never straddle the end
+    auto* const record = _buffer.data() + allocation->begin;
+    write(std::span{record + HEADER_SIZE, size});
+
+    auto const header = static_cast<uint32_t>(size + 1);
+
+    if constexpr(Producers == RingProducers::SINGLE) {
+        std::memcpy(record, &header, sizeof(header));
+
+        auto const published = _published.load(std::memory_order::relaxed);
+        _published.store(published + total, std::memory_order::release);
+    } else
+        std::atomic_ref{*reinterpret_cast<uint32_t*>(record)}.store(header, std::memory_order::release);
+
+    return true;
+}
+
+template<RingProducers Producers, RingConsumers Consumers>
+template<class Fn>
+size_t basic_ring_queue<Producers, Consumers>::drain(Fn&& read, size_t max_records) {
+    if constexpr(Consumers == RingConsumers::MULTI) {
+        std::scoped_lock lock{_consumerMutex};
+        return drainRecords(read, max_records);
+    } else
+        return drainRecords(read, max_records);
+}
+
+template<RingProducers Producers, RingConsumers Consumers>
+template<class Fn>
+size_t basic_ring_queue<Producers, Consumers>::drainRecords(Fn& read, size_t max_records) {
+    auto const begin = _readPos;
+
+    // multiple producers publish per header, the allocated range bounds the walk to a single lap
+    auto const published = Producers == RingProducers::SINGLE ? _published.load(std::memory_order::acquire)
+                                                              : begin + _alloc.allocated();
+
+    auto pos = begin;
+    size_t count = 0;
+
+    for(; count < max_records && pos != published; ++count) {
+        auto* const record = at(pos);
+
+        uint32_t header;
+        if constexpr(Producers == RingProducers::SINGLE)
+            std::memcpy(&header, record, sizeof(header));
+        else
+            header = std::atomic_ref{*reinterpret_cast<uint32_t*>(record)}.load(std::memory_order::acquire);
+
+        if(header == UNPUBLISHED)
+            break;
+
+        auto const size = size_t{header} - 1;
+        read(std::span<std::byte const>{record + HEADER_SIZE, size});
+
+        pos += recordSize(size);
+    }
+
+    if(pos == begin)
+        return 0;
+
+    // later headers may land anywhere in the consumed range, they must read as unpublished
+    if constexpr(Producers == RingProducers::MULTI)
+        std::memset(at(begin), 0, pos - begin);
+
+    _readPos = pos;
+    _alloc.free_front(pos - begin);
+
+    return count;
+}
+
+}
@@ -1,11 +1,20 @@
 #pragma once
 
+#include "cth/constants.hpp"
 #include "cth/io/log.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <coroutine>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <type_traits>
+#include <utility>
 
 namespace cth::dt {
 
@@ -18,28 +27,59 @@ namespace dev {
     constexpr size_t CLEANUP_ALLOC_SIZE_BITS = sizeof(cleanup_t) * 8 - CLEANUP_COUNTER_BITS;
 }
 
+/**
+ * how an allocation that would straddle the end of the ring is placed
+ */
+enum class RingWrap : uint8_t {
+    /**
+     * restarts at offset 0, the skipped end of the ring counts as allocated until freed
+     */
+    PAD,
+    /**
+     * continues past the end, the buffer must be mapped twice back to back (see @ref mirrored_buffer)
+     */
+    MIRRORED,
+};
+
 struct ring_allocation {
     size_t begin;
     cleanup_t cleanup;
 };
 
+/**
+ * resumes coroutines on its own threads, e.g. cth::co::scheduler
+ */
+template<class T>
+concept ring_scheduler = requires(T const& scheduler, std::move_only_function<void()> job) {
+    scheduler.post(std::move(job));
+};
+
 
 /**
  * ring allocator with contiguous allocation guarantee
  * @details
  * - operates under FIFO / cumulative free assumption, i.e. freeing allocation B after A assumes A can be overwritten
  * - fully thread safe
+ * - producers can block (@ref alloc_wait()) or suspend (@ref alloc_async()) until frees make space,
+ *   frees without waiters pay no extra synchronization
+ * - producers can sub allocate from a thread owned chunk (@ref reservation) to take contention off the head,
+ *   frees must not pass a chunk still in use then
+ * @note see @ref completion_ring_alloc for out of order frees
  */
 class ring_alloc {
     using pos_t = uint64_t;
     using counter_t = uint16_t;
 
 public:
+    class alloc_awaiter;
+    class reservation;
+
     /**
      * creates the ring allocator for a given buffer size
      * @param size in bytes
+     * @param wrap mode, @ref RingWrap::MIRRORED allocations may end at most size bytes past the buffer begin
      */
-    constexpr ring_alloc(size_t size) : _size{size} {}
+    constexpr ring_alloc(size_t size, RingWrap wrap = RingWrap::PAD) : _size{size}, _wrap{wrap} {}
 
     /**
      * allocates
@@ -59,7 +99,7 @@ public:
             auto const actualHead = head % _size;
 
             // ring wrap
-            bool const wrap = (actualHead + size) > _size;
+            bool const wrap = _wrap == RingWrap::PAD && (actualHead + size) > _size;
 
             begin = wrap ? 0 : actualHead;
 
@@ -86,6 +126,50 @@ public:
         return ring_allocation{begin, create_token(head, totalSize)};
     }
 
+    /**
+     * allocates without the CAS loop, for single producers
+     * @param size to allocate (< @ref max_alloc())
+     * @return alloc info or empty if not enough space
+     * @attention must not race with other allocations
+     */
+    [[nodiscard]] std::optional<ring_allocation> alloc_exclusive(size_t size) {
+        auto const head = _head.load(std::memory_order::relaxed);
+        auto const tail = _tail.load(std::memory_order::acquire);
+
+        auto const actualHead = head % _size;
+        bool const wrap = _wrap == RingWrap::PAD && (actualHead + size) > _size;
+
+        auto const totalSize = wrap ? size + (_size - actualHead) : size;
+        if(head + totalSize - tail > _size)
+            return std::nullopt;
+
+        _head.store(head + totalSize, std::memory_order::release);
+
+        return ring_allocation{wrap ? 0 : actualHead, create_token(head, totalSize)};
+    }
+
+    /**
+     * allocates, blocks until enough space is freed
+     * @param size to allocate, <= size() / 2 with @ref RingWrap::PAD, <= size() with @ref RingWrap::MIRRORED
+     * @return alloc info
+     * @details sleeps on the tail via std::atomic::wait, no spinning
+     */
+    [[nodiscard]] ring_allocation alloc_wait(size_t size);
+
+    /**
+     * allocates, suspends the awaiting coroutine until enough space is freed
+     * @param size to allocate, see @ref alloc_wait()
+     * @param scheduler posts the resumption, must outlive the suspension
+     * @return awaiter, co_await yields the alloc info
+     * @details
+     * - suspended requests are served in FIFO order by the @ref free() that made space,
+     *   the coroutine is resumed through scheduler.post(), never inline in free()
+     * - destroying a suspended coroutine withdraws its request
+     * @attention a coroutine must not be destroyed after its resumption was posted
+     */
+    template<ring_scheduler Scheduler>
+    [[nodiscard]] alloc_awaiter alloc_async(size_t size, Scheduler const& scheduler);
+
     /**
      * frees the allocation.
      * @param token to free
@@ -95,14 +179,32 @@ public:
         auto tail = _tail.load(std::memory_order::acquire);
         auto const pos = end(token);
 
-        while(
-            tail < pos
-            && !_tail.compare_exchange_weak(
-                tail,
-                pos,
-                std::memory_order::release,
-                std::memory_order::relaxed
-            )) {}
+        while(tail < pos) {
+            // seq_cst pairs with registerWaiter(), see wakeWaiters()
+            if(!_tail.compare_exchange_weak(
+                   tail,
+                   pos,
+                   std::memory_order::seq_cst,
+                   std::memory_order::relaxed
+               ))
+                continue;
+
+            wakeWaiters();
+            return;
+        }
+    }
+
+    /**
+     * frees the oldest bytes, for consumers that walk the allocations in order
+     * @param bytes to free, including wrap padding
+     * @attention must not race with other frees
+     */
+    void free_front(size_t bytes) {
+        if(bytes == 0)
+            return;
+
+        _tail.store(_tail.load(std::memory_order::relaxed) + bytes, std::memory_order::seq_cst);
+        wakeWaiters();
     }
 
 
@@ -133,6 +235,9 @@ public:
         if(head - tail >= capacity())
             return 0;
 
+        if(_wrap == RingWrap::MIRRORED)
+            return capacity() - (head - tail);
+
         auto const actualHead = head % _size;
         auto const actualTail = tail % _size;
 
@@ -148,6 +253,21 @@ public:
     }
 
 private:
+    /**
+     * wakes blocked producers and posts the suspended ones that fit now
+     * @pre the tail was advanced with a seq_cst operation
+     */
+    void wakeWaiters();
+    void resumeAsync();
+
+    /**
+     * counts a waiter
+     * @return tail after the registration, any later advance of the tail sees the waiter
+     */
+    pos_t registerWaiter();
+
+    [[nodiscard]] size_t maxWaitSize() const { return _wrap == RingWrap::PAD ? _size / 2 : _size; }
+
     [[nodiscard]] static constexpr cleanup_t create_token(size_t head, size_t actual_alloc_size) {
         return static_cast<cleanup_t>(head + actual_alloc_size);
     }
@@ -155,8 +275,513 @@ private:
     [[nodiscard]] static constexpr size_t end(cleanup_t token) { return static_cast<size_t>(token); }
 
     size_t _size;
-    std::atomic<pos_t> _head{};
-    std::atomic<pos_t> _tail{};
+    RingWrap _wrap;
+
+    // producers hit the head, consumers the tail, separate cache lines keep them from false sharing
+    alignas(CACHE_LINE_SIZE) std::atomic<pos_t> _head{};
+    alignas(CACHE_LINE_SIZE) std::atomic<pos_t> _tail{};
+
+    // blocked + suspended producers, checked by every advancing free
+    std::atomic<uint32_t> _waiters{};
+
+    // intrusive doubly linked FIFO of suspended producers
+    std::mutex _asyncMutex{};
+    alloc_awaiter* _asyncFront = nullptr;
+    alloc_awaiter* _asyncBack = nullptr;
+};
+
+/**
+ * awaiter of @ref ring_alloc::alloc_async()
+ */
+class ring_alloc::alloc_awaiter {
+public:
+    /**
+     * withdraws the request if the coroutine is destroyed while suspended
+     */
+    ~alloc_awaiter();
+
+    [[nodiscard]] bool await_ready() {
+        _result = _ring->alloc(_size);
+        return _result.has_value();
+    }
+    [[nodiscard]] bool await_suspend(std::coroutine_handle<> handle);
+    [[nodiscard]] ring_allocation await_resume() const { return *_result; }
+
+private:
+    template<class Scheduler>
+    alloc_awaiter(ring_alloc& ring, size_t size, Scheduler const& scheduler) :
+        _ring{&ring},
+        _size{size},
+        _scheduler{&scheduler},
+        _post{[](void const* s, std::coroutine_handle<> handle) {
+            static_cast<Scheduler const*>(s)->post([handle] { handle.resume(); });
+        }} {}
+
+    ring_alloc* _ring;
+    size_t _size;
+    void const* _scheduler;
+    void (*_post)(void const*, std::coroutine_handle<>);
+
+    std::coroutine_handle<> _handle{};
+    std::optional<ring_allocation> _result{};
+
+    // guarded by the ring's async mutex
+    alloc_awaiter* _prev = nullptr;
+    alloc_awaiter* _next = nullptr;
+    bool _queued = false;
+
+    friend class ring_alloc;
+
+public:
+    // queued by address
+    alloc_awaiter(alloc_awaiter const& other) = delete;
+    alloc_awaiter(alloc_awaiter&& other) = delete;
+    alloc_awaiter& operator=(alloc_awaiter const& other) = delete;
+    alloc_awaiter& operator=(alloc_awaiter&& other) = delete;
 };
 
+/**
+ * thread owned chunk of a @ref ring_alloc, sub allocations need no atomic operations
+ * @details
+ * - a chunk is reserved with a single head CAS, requests that don't fit into the rest trigger a new one
+ * - on flush the unused rest is handed back if nothing was allocated behind the chunk,
+ *   else it stays as padding that is freed by the frees after it
+ * - sub allocation tokens are ordered by position, the cumulative free assumption applies to positions
+ * @attention
+ * freeing a record implicitly frees the unused rest of every chunk before it, including chunks other threads
+ * still sub allocate from. their next allocations would overlap memory the ring hands out again:
+ * - records must be freed in global position order across all threads
+ * - a record behind another reservation's chunk may only be freed once that reservation is flushed
+ * - e.g. producers flush at the end of a batch, the batch is freed once every producer flushed
+ * - checked on the next sub allocation in debug builds
+ * - use @ref completion_ring_alloc without reservations if records complete in any order
+ * @note one per producer thread, flushes on destruction
+ */
+class ring_alloc::reservation {
+public:
+    /**
+     * @param ring to reserve from
+     * @param chunk_size of a reservation in bytes
+     */
+    reservation(ring_alloc& ring, size_t chunk_size) : _ring{&ring}, _chunkSize{chunk_size} {}
+    ~reservation() { flush(); }
+
+    /**
+     * allocates from the reserved chunk
+     * @param size to allocate
+     * @return alloc info or empty if a new chunk can't be reserved
+     */
+    [[nodiscard]] std::optional<ring_allocation> alloc(size_t size);
+
+    /**
+     * releases the unused rest of the chunk
+     */
+    void flush();
+
+private:
+    [[nodiscard]] bool refill(size_t size);
+
+    ring_alloc* _ring;
+    size_t _chunkSize;
+
+    // absolute positions in the ring
+    pos_t _pos = 0;
+    pos_t _end = 0;
+
+public:
+    [[nodiscard]] size_t chunk_size() const { return _chunkSize; }
+    /**
+     * unused bytes of the current chunk
+     */
+    [[nodiscard]] size_t reserved() const { return _end - _pos; }
+
+    reservation(reservation const& other) = delete;
+    reservation(reservation&& other) = delete;
+    reservation& operator=(reservation const& other) = delete;
+    reservation& operator=(reservation&& other) = delete;
+};
+
+
+/**
+ * ring allocator with contiguous allocation guarantee, allocations may be freed in any order
+ * @details
+ * - completion is tracked per allocation in a ring of slots, the tail only advances over contiguously freed
+ *   allocations
+ * - at most @ref max_allocations() allocations are in flight at once
+ * - fully thread safe, lock free
+ */
+class completion_ring_alloc {
+    using pos_t = uint64_t;
+
+    // head / tail / token layout: [unused:1][sequence:15][position:48]
+    static constexpr size_t POS_BITS = dev::CLEANUP_ALLOC_SIZE_BITS;
+    static constexpr size_t SEQ_BITS = dev::CLEANUP_COUNTER_BITS - 1;
+    static constexpr pos_t POS_MASK = (pos_t{1} << POS_BITS) - 1;
+    static constexpr pos_t SEQ_MASK = (pos_t{1} << SEQ_BITS) - 1;
+
+    // never a token, the unused bit is always 0 in tokens
+    static constexpr pos_t EMPTY_SLOT = ~pos_t{0};
+
+public:
+    static constexpr size_t MAX_ALLOCATIONS = size_t{1} << (SEQ_BITS - 1);
+    static constexpr size_t DEFAULT_MAX_ALLOCATIONS = 1024;
+
+    /**
+     * creates the ring allocator for a given buffer size
+     * @param size in bytes, < 2^47
+     * @param max_allocations in flight, rounded up to a power of two, <= @ref MAX_ALLOCATIONS
+     */
+    explicit completion_ring_alloc(size_t size, size_t max_allocations = DEFAULT_MAX_ALLOCATIONS);
+
+    /**
+     * creates the ring allocator for a given buffer size
+     * @param size in bytes, < 2^47
+     * @param wrap mode, @ref RingWrap::MIRRORED allocations may end at most size bytes past the buffer begin
+     * @param max_allocations in flight, rounded up to a power of two, <= @ref MAX_ALLOCATIONS
+     */
+    completion_ring_alloc(size_t size, RingWrap wrap, size_t max_allocations = DEFAULT_MAX_ALLOCATIONS);
+
+    /**
+     * allocates
+     * @param size to allocate (< @ref max_alloc())
+     * @return alloc info or empty if not enough space or all completion slots are in flight
+     */
+    [[nodiscard]] std::optional<ring_allocation> alloc(size_t size);
+
+    /**
+     * frees the allocation, any order
+     * @param token to free
+     * @details the space is reusable once all earlier allocations are freed as well
+     */
+    void free(cleanup_t token);
+
+    [[nodiscard]] size_t size() const { return _size; }
+    /**
+     * alias for size
+     */
+    [[nodiscard]] size_t capacity() const { return size(); }
+    /**
+     * max allocations in flight
+     */
+    [[nodiscard]] size_t max_allocations() const { return _slotCount; }
+
+    /**
+     * allocated bytes, including freed allocations the tail can't pass yet
+     * @note may not be used to determine the max allocation, use @ref max_alloc() instead
+     */
+    [[nodiscard]] size_t allocated() const {
+        auto const head = _head.load(std::memory_order::relaxed);
+        return distance(posOf(head), posOf(_tail.load(std::memory_order::relaxed)));
+    }
+
+    /**
+     * gets the current max allocation size
+     * @return size in bytes
+     * @note in highly threaded environments this may not be accurate
+     */
+    [[nodiscard]] size_t max_alloc() const;
+
+private:
+    /**
+     * consumes contiguously completed slots at the tail
+     */
+    void advanceTail();
+
+    [[nodiscard]] static constexpr pos_t pack(pos_t seq, pos_t pos) {
+        return ((seq & SEQ_MASK) << POS_BITS) | pos;
+    }
+    [[nodiscard]] static constexpr pos_t posOf(pos_t packed) { return packed & POS_MASK; }
+    [[nodiscard]] static constexpr pos_t seqOf(pos_t packed) { return (packed >> POS_BITS) & SEQ_MASK; }
+
+    // positions run modulo a multiple of the size, so pos % size stays the physical offset across wraps
+    [[nodiscard]] size_t distance(pos_t to, pos_t from) const {
+        return static_cast<size_t>((to + _posModulus - from) % _posModulus);
+    }
+
+    size_t _size;
+    RingWrap _wrap;
+    pos_t _posModulus;
+    size_t _slotCount;
+
+    std::unique_ptr<std::atomic<pos_t>[]> _slots;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<pos_t> _head{};
+    alignas(CACHE_LINE_SIZE) std::atomic<pos_t> _tail{};
+
+public:
+    completion_ring_alloc(completion_ring_alloc const& other) = delete;
+    completion_ring_alloc(completion_ring_alloc&& other) = delete;
+    completion_ring_alloc& operator=(completion_ring_alloc const& other) = delete;
+    completion_ring_alloc& operator=(completion_ring_alloc&& other) = delete;
+};
+
+}
+
+namespace cth::dt {
+
+inline ring_allocation ring_alloc::alloc_wait(size_t size) {
+    CTH_CRITICAL(size > maxWaitSize(), "allocation may never fit, waiting would deadlock") {}
+
+    if(auto const result = alloc(size))
+        return *result;
+
+    auto tail = registerWaiter();
+
+    while(true) {
+        if(auto const result = alloc(size)) {
+            _waiters.fetch_sub(1, std::memory_order::relaxed);
+            return *result;
+        }
+
+        _tail.wait(tail, std::memory_order::relaxed);
+        tail = _tail.load(std::memory_order::relaxed);
+    }
+}
+
+template<ring_scheduler Scheduler>
+auto ring_alloc::alloc_async(size_t size, Scheduler const& scheduler) -> alloc_awaiter {
+    CTH_CRITICAL(size > maxWaitSize(), "allocation may never fit, waiting would deadlock") {}
+
+    return alloc_awaiter{*this, size, scheduler};
+}
+
+inline auto ring_alloc::registerWaiter() -> pos_t {
+    _waiters.fetch_add(1, std::memory_order::seq_cst);
+    return _tail.load(std::memory_order::seq_cst);
+}
+
+inline void ring_alloc::wakeWaiters() {
+    // the tail advance and the registration are both seq_cst:
+    // either this sees the waiter or the waiter's tail load sees the advance, no fence needed
+    if(_waiters.load(std::memory_order::seq_cst) == 0)
+        return;
+
+    _tail.notify_all();
+    resumeAsync();
+}
+
+inline void ring_alloc::resumeAsync() {
+    while(true) {
+        alloc_awaiter* ready = nullptr;
+        {
+            std::scoped_lock lock{_asyncMutex};
+
+            // strict FIFO, a big request at the front is not starved by smaller ones behind it
+            if(_asyncFront == nullptr)
+                return;
+
+            _asyncFront->_result = alloc(_asyncFront->_size);
+            if(!_asyncFront->_result)
+                return;
+
+            ready = std::exchange(_asyncFront, _asyncFront->_next);
+            if(_asyncFront == nullptr)
+                _asyncBack = nullptr;
+            else
+                _asyncFront->_prev = nullptr;
+
+            ready->_queued = false;
+        }
+
+        _waiters.fetch_sub(1, std::memory_order::relaxed);
+
+        // user code runs on the scheduler, not inside free()
+        ready->_post(ready->_scheduler, ready->_handle);
+    }
+}
+
+inline ring_alloc::alloc_awaiter::~alloc_awaiter() {
+    if(!_handle)
+        return;
+
+    std::scoped_lock lock{_ring->_asyncMutex};
+    if(!_queued)
+        return;
+
+    (_prev != nullptr ? _prev->_next : _ring->_asyncFront) = _next;
+    (_next != nullptr ? _next->_prev : _ring->_asyncBack) = _prev;
+
+    _ring->_waiters.fetch_sub(1, std::memory_order::relaxed);
+}
+
+inline bool ring_alloc::alloc_awaiter::await_suspend(std::coroutine_handle<> handle) {
+    _handle = handle;
+
+    // registering under the lock keeps resumeAsync() from seeing a half registered awaiter
+    std::scoped_lock lock{_ring->_asyncMutex};
+
+    static_cast<void>(_ring->registerWaiter());
+
+    // space may have been freed since await_ready()
+    _result = _ring->alloc(_size);
+    if(_result) {
+        _ring->_waiters.fetch_sub(1, std::memory_order::relaxed);
+        return false;
+    }
+
+    _prev = _ring->_asyncBack;
+    (_prev != nullptr ? _prev->_next : _ring->_asyncFront) = this;
+    _ring->_asyncBack = this;
+    _queued = true;
+
+    return true;
+}
+
+inline std::optional<ring_allocation> ring_alloc::reservation::alloc(size_t size) {
+    CTH_CRITICAL(
+        _pos != _end && _ring->_tail.load(std::memory_order::relaxed) > _pos,
+        "a free passed the unused rest of this chunk, see reservation free order"
+    ) {}
+
+    if(_end - _pos < size && !refill(size))
+        return std::nullopt;
+
+    auto const begin = _pos;
+    _pos += size;
+
+    // absolute positions are congruent to physical offsets, wrap padding always ends on a multiple of size
+    return ring_allocation{begin % _ring->_size, create_token(begin, size)};
+}
+
+inline void ring_alloc::reservation::flush() {
+    if(_pos == _end)
+        return;
+
+    // fails if something was allocated behind the chunk, the rest is freed with it then
+    auto expected = _end;
+    _ring->_head.compare_exchange_strong(expected, _pos, std::memory_order::relaxed);
+
+    _end = _pos;
+}
+
+inline bool ring_alloc::reservation::refill(size_t size) {
+    flush();
+
+    auto const chunkSize = std::max(size, _chunkSize);
+    auto chunk = _ring->alloc(chunkSize);
+
+    // a small request may still fit when a full chunk doesn't
+    auto reserved = chunkSize;
+    if(!chunk && size < chunkSize) {
+        chunk = _ring->alloc(size);
+        reserved = size;
+    }
+
+    if(!chunk)
+        return false;
+
+    _end = end(chunk->cleanup);
+    _pos = _end - reserved;
+    return true;
+}
+
+inline completion_ring_alloc::completion_ring_alloc(size_t size, size_t max_allocations) :
+    completion_ring_alloc{size, RingWrap::PAD, max_allocations} {}
+
+inline completion_ring_alloc::completion_ring_alloc(size_t size, RingWrap wrap, size_t max_allocations) :
+    _size{size},
+    _wrap{wrap},
+    _posModulus{(POS_MASK + 1) / std::max<pos_t>(size, 1) * std::max<pos_t>(size, 1)},
+    _slotCount{std::bit_ceil(std::max<size_t>(max_allocations, 1))},
+    _slots{std::make_unique<std::atomic<pos_t>[]>(_slotCount)} {
+    CTH_CRITICAL(size >= (pos_t{1} << (POS_BITS - 1)), "ring too big for the position bits") {}
+    CTH_CRITICAL(_slotCount > MAX_ALLOCATIONS, "too many allocations in flight for the sequence bits") {}
+
+    for(size_t i = 0; i < _slotCount; ++i)
+        _slots[i].store(EMPTY_SLOT, std::memory_order::relaxed);
+}
+
+inline std::optional<ring_allocation> completion_ring_alloc::alloc(size_t size) {
+    auto head = _head.load(std::memory_order::relaxed);
+
+    size_t begin;
+    pos_t end;
+
+    while(true) {
+        auto const tail = _tail.load(std::memory_order::acquire);
+
+        // out of completion slots
+        if(((seqOf(head) - seqOf(tail)) & SEQ_MASK) >= _slotCount)
+            return std::nullopt;
+
+        auto const headPos = posOf(head);
+        auto const actualHead = static_cast<size_t>(headPos % _size);
+
+        // ring wrap
+        bool const wrap = _wrap == RingWrap::PAD && (actualHead + size) > _size;
+
+        begin = wrap ? 0 : actualHead;
+
+        // add wrap padding
+        auto const totalSize = wrap ? size + (_size - actualHead) : size;
+
+        // not enough space
+        if(distance(headPos, posOf(tail)) + totalSize > _size)
+            return std::nullopt;
+
+        end = (headPos + totalSize) % _posModulus;
+
+        if(_head.compare_exchange_weak(
+               head,
+               pack(seqOf(head) + 1, end),
+               std::memory_order::release,
+               std::memory_order::relaxed
+           ))
+            break;
+    }
+
+    return ring_allocation{begin, static_cast<cleanup_t>(pack(seqOf(head), end))};
+}
+
+inline void completion_ring_alloc::free(cleanup_t token) {
+    auto const packed = static_cast<pos_t>(token);
+
+    // seq_cst pairs with advanceTail(), this thread sees the new tail or the advancing thread sees the slot
+    _slots[seqOf(packed) & (_slotCount - 1)].store(packed, std::memory_order::seq_cst);
+
+    advanceTail();
+}
+
+inline void completion_ring_alloc::advanceTail() {
+    while(true) {
+        auto const tail = _tail.load(std::memory_order::seq_cst);
+        auto& slot = _slots[seqOf(tail) & (_slotCount - 1)];
+
+        auto completed = slot.load(std::memory_order::seq_cst);
+        if(completed == EMPTY_SLOT || seqOf(completed) != seqOf(tail))
+            return;
+
+        // the thread emptying the slot owns the tail step
+        if(!slot.compare_exchange_strong(completed, EMPTY_SLOT, std::memory_order::seq_cst))
+            continue;
+
+        _tail.store(pack(seqOf(tail) + 1, posOf(completed)), std::memory_order::seq_cst);
+    }
+}
+
+inline size_t completion_ring_alloc::max_alloc() const {
+    auto const head = _head.load(std::memory_order::relaxed);
+    auto const tail = _tail.load(std::memory_order::relaxed);
+
+    if(((seqOf(head) - seqOf(tail)) & SEQ_MASK) >= _slotCount)
+        return 0;
+
+    auto const used = distance(posOf(head), posOf(tail));
+    if(used >= capacity())
+        return 0;
+
+    if(_wrap == RingWrap::MIRRORED)
+        return capacity() - used;
+
+    auto const actualHead = static_cast<size_t>(posOf(head) % _size);
+    auto const actualTail = static_cast<size_t>(posOf(tail) % _size);
+
+    // [..., h <..free..> t ...]
+    if(actualHead < actualTail)
+        return actualTail - actualHead;
+
+    // [..> t ... h <..free]
+    return std::max(_size - actualHead, actualTail);
+}
+
 }
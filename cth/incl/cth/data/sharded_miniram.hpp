@@ -0,0 +1,346 @@
+#pragma once
+#include "cth/constants.hpp"
+#include "cth/data/miniram.hpp"
+#include "cth/io/log.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace cth::dt {
+
+/**
+ * thread safe miniram, splits the capacity into independently locked shards
+ * @details
+ * - every thread gets a home shard (round robin on first use)
+ * - if the home shard can't serve a request the other shards are tried (work stealing)
+ * - offsets are global, ids encode the owning shard in the low bits
+ * - max allocation is limited by the shard capacity
+ */
+template<uint SizeType, uint IndexType>
+class basic_sharded_miniram {
+public:
+    using ram_type = basic_miniram<SizeType, IndexType>;
+    using size_type = SizeType;
+    using index_type = IndexType;
+    using alloc_type = typename ram_type::alloc_type;
+    using defrag_type = typename ram_type::defrag_type;
+
+    static constexpr index_type INVALID_INDEX = ram_type::INVALID_INDEX;
+    static constexpr size_type NO_SPACE = ram_type::NO_SPACE;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) shard {
+        shard(size_type shard_base, size_type shard_capacity, size_t initial_alloc_capacity) :
+            base{shard_base}, ram{shard_capacity, initial_alloc_capacity} {}
+
+        std::mutex mutex{};
+        size_type base;
+        ram_type ram;
+    };
+
+public:
+    /**
+     * constructs
+     * @param capacity of ram (in elements), the last shard receives the remainder
+     * @param shard_count number of shards, clamped to [1, capacity]
+     * @param initial_alloc_capacity per shard (in allocations), >= 1
+     */
+    explicit basic_sharded_miniram(
+        size_type capacity,
+        size_t shard_count = std::max(std::thread::hardware_concurrency(), 1u),
+        size_t initial_alloc_capacity = 16 * 1024
+    );
+
+    /**
+     * allocates a block, tries the home shard first and steals from the others if that fails
+     * @param size (in elements)
+     * @return allocation (offset, id) or (NO_SPACE, INVALID_INDEX)
+     */
+    [[nodiscard]] alloc_type allocate(size_type size);
+
+    /**
+     * frees an allocation, may be called from any thread
+     * @param allocation to free
+     */
+    void free(alloc_type allocation);
+
+    /**
+     * frees a batch of allocations, may be called from any thread
+     * @param allocations to free, in any order
+     * @details every touched shard is locked once
+     */
+    void free_n(std::span<alloc_type const> allocations);
+
+    /**
+     * queries an allocation's size
+     * @param allocation to check
+     * @return size in elements
+     */
+    [[nodiscard]] size_type size_of(alloc_type allocation) const;
+
+    /**
+     * defragments every shard (left compaction within the shard)
+     * @return merged report with global offsets and encoded ids
+     * @note shards are compacted one after another, each only locked while it is compacted.
+     *       the other shards keep serving calls, the merged report is consistent per shard only
+     */
+    [[nodiscard]] defrag_type defragment();
+
+    /**
+     * clears all shards to no allocations
+     */
+    void clear();
+
+private:
+    [[nodiscard]] size_t homeShard() const { return threadId() % _shardCount; }
+    [[nodiscard]] static size_t threadId();
+
+    [[nodiscard]] alloc_type tryAllocate(shard& target, size_t shard_index, size_type size);
+    [[nodiscard]] alloc_type toGlobal(size_t shard_index, alloc_type local) const;
+    [[nodiscard]] index_type encodeId(size_t shard_index, index_type local_id) const;
+    [[nodiscard]] size_t shardIndexOf(index_type id) const { return id & _shardMask; }
+    [[nodiscard]] index_type localIdOf(index_type id) const { return id >> _shardBits; }
+
+    size_type _capacity;
+    size_t _shardCount;
+    size_t _shardBits;
+    index_type _shardMask;
+
+    std::vector<std::unique_ptr<shard>> _shards{};
+
+public:
+    /**
+     * amount of elements in ram
+     */
+    [[nodiscard]] size_type capacity() const { return _capacity; }
+    /**
+     * number of independently locked shards
+     */
+    [[nodiscard]] size_t shard_count() const { return _shardCount; }
+    /**
+     * amount of unallocated elements left in ram
+     * @note snapshot, may be outdated immediately in threaded environments
+     */
+    [[nodiscard]] size_type remaining() const;
+    /**
+     * amount of allocated elements in ram
+     * @note snapshot, may be outdated immediately in threaded environments
+     */
+    [[nodiscard]] size_type allocated() const { return capacity() - remaining(); }
+    /**
+     * max allocatable block size over all shards (in elements)
+     * @note snapshot, may be outdated immediately in threaded environments
+     */
+    [[nodiscard]] size_type max_alloc() const;
+
+    basic_sharded_miniram(basic_sharded_miniram const& other) = delete;
+    basic_sharded_miniram(basic_sharded_miniram&& other) noexcept = default;
+    basic_sharded_miniram& operator=(basic_sharded_miniram const& other) = delete;
+    basic_sharded_miniram& operator=(basic_sharded_miniram&& other) noexcept = default;
+};
+
+using sharded_miniram32 = basic_sharded_miniram<uint32_t, uint32_t>;
+using sharded_miniram64 = basic_sharded_miniram<uint64_t, uint32_t>;
+using sharded_miniram = basic_sharded_miniram<size_t, uint32_t>;
+
+}
+
+namespace cth::dt {
+
+template<uint SizeType, uint IndexType>
+basic_sharded_miniram<SizeType, IndexType>::basic_sharded_miniram(
+    size_type capacity,
+    size_t shard_count,
+    size_t initial_alloc_capacity
+) : _capacity{capacity},
+    _shardCount{std::clamp<size_t>(shard_count, 1, std::max<size_t>(capacity, 1))},
+    _shardBits{static_cast<size_t>(std::bit_width(_shardCount - 1))},
+    _shardMask{static_cast<index_type>((index_type{1} << _shardBits) - 1)} {
+    CTH_CRITICAL(_shardBits >= std::numeric_limits<index_type>::digits, "too many shards for index type") {}
+
+    auto const shardCapacity = static_cast<size_type>(capacity / _shardCount);
+
+    _shards.reserve(_shardCount);
+    for(size_t i = 0; i < _shardCount; ++i) {
+        auto const base = static_cast<size_type>(i * shardCapacity);
+        auto const size = i == _shardCount - 1 ? capacity - base : shardCapacity;
+
+        _shards.push_back(std::make_unique<shard>(base, size, initial_alloc_capacity));
+    }
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_sharded_miniram<SizeType, IndexType>::allocate(size_type size) -> alloc_type {
+    auto const home = homeShard();
+
+    {
+        auto& target = *_shards[home];
+        std::scoped_lock lock{target.mutex};
+
+        if(auto const alloc = tryAllocate(target, home, size); alloc.id != INVALID_INDEX)
+            return alloc;
+    }
+
+    // steal from uncontended shards first
+    for(size_t i = 1; i < _shardCount; ++i) {
+        auto const index = (home + i) % _shardCount;
+        auto& target = *_shards[index];
+
+        std::unique_lock lock{target.mutex, std::try_to_lock};
+        if(!lock.owns_lock())
+            continue;
+
+        if(auto const alloc = tryAllocate(target, index, size); alloc.id != INVALID_INDEX)
+            return alloc;
+    }
+
+    for(size_t i = 1; i < _shardCount; ++i) {
+        auto const index = (home + i) % _shardCount;
+        auto& target = *_shards[index];
+
+        std::scoped_lock lock{target.mutex};
+
+        if(auto const alloc = tryAllocate(target, index, size); alloc.id != INVALID_INDEX)
+            return alloc;
+    }
+
+    return {.offset = NO_SPACE, .id = INVALID_INDEX};
+}
+
+template<uint SizeType, uint IndexType>
+void basic_sharded_miniram<SizeType, IndexType>::free(alloc_type allocation) {
+    auto const index = shardIndexOf(allocation.id);
+    CTH_CRITICAL(allocation.id == INVALID_INDEX || index >= _shardCount, "invalid allocation id") {}
+
+    auto& target = *_shards[index];
+
+    std::scoped_lock lock{target.mutex};
+    target.ram.free({.offset = allocation.offset - target.base, .id = localIdOf(allocation.id)});
+}
+
+template<uint SizeType, uint IndexType>
+void basic_sharded_miniram<SizeType, IndexType>::free_n(std::span<alloc_type const> allocations) {
+    std::vector<alloc_type> sorted{allocations.begin(), allocations.end()};
+    std::ranges::sort(sorted, {}, [this](alloc_type const& alloc) { return shardIndexOf(alloc.id); });
+
+    std::vector<alloc_type> local{};
+    local.reserve(sorted.size());
+
+    for(size_t begin = 0; begin < sorted.size();) {
+        auto const index = shardIndexOf(sorted[begin].id);
+        CTH_CRITICAL(sorted[begin].id == INVALID_INDEX || index >= _shardCount, "invalid allocation id") {}
+
+        auto& target = *_shards[index];
+
+        local.clear();
+        for(; begin < sorted.size() && shardIndexOf(sorted[begin].id) == index; ++begin) {
+            auto const& alloc = sorted[begin];
+            local.push_back({.offset = alloc.offset - target.base, .id = localIdOf(alloc.id)});
+        }
+
+        std::scoped_lock lock{target.mutex};
+        target.ram.free_n(local);
+    }
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_sharded_miniram<SizeType, IndexType>::size_of(alloc_type allocation) const -> size_type {
+    if(allocation.id == INVALID_INDEX)
+        return 0;
+
+    auto& target = *_shards[shardIndexOf(allocation.id)];
+
+    std::scoped_lock lock{target.mutex};
+    return target.ram.size_of({.offset = allocation.offset - target.base, .id = localIdOf(allocation.id)});
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_sharded_miniram<SizeType, IndexType>::defragment() -> defrag_type {
+    defrag_type report{};
+
+    for(size_t i = 0; i < _shardCount; ++i) {
+        auto& target = *_shards[i];
+
+        std::scoped_lock lock{target.mutex};
+        auto const shardReport = target.ram.defragment();
+
+        for(auto const& alloc : shardReport.updatedAllocs)
+            report.updatedAllocs.push_back(toGlobal(i, alloc));
+
+        for(auto const& move : shardReport.moves)
+            report.moves.emplace_back(move.srcOffset + target.base, move.dstOffset + target.base, move.size);
+    }
+
+    return report;
+}
+
+template<uint SizeType, uint IndexType>
+void basic_sharded_miniram<SizeType, IndexType>::clear() {
+    for(size_t i = 0; i < _shardCount; ++i) {
+        std::scoped_lock lock{_shards[i]->mutex};
+        _shards[i]->ram.clear();
+    }
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_sharded_miniram<SizeType, IndexType>::remaining() const -> size_type {
+    size_type result = 0;
+    for(size_t i = 0; i < _shardCount; ++i) {
+        std::scoped_lock lock{_shards[i]->mutex};
+        result += _shards[i]->ram.remaining();
+    }
+    return result;
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_sharded_miniram<SizeType, IndexType>::max_alloc() const -> size_type {
+    size_type result = 0;
+    for(size_t i = 0; i < _shardCount; ++i) {
+        std::scoped_lock lock{_shards[i]->mutex};
+        result = std::max(result, _shards[i]->ram.max_alloc());
+    }
+    return result;
+}
+
+template<uint SizeType, uint IndexType>
+size_t basic_sharded_miniram<SizeType, IndexType>::threadId() {
+    static std::atomic<size_t> nextId{0};
+    thread_local size_t const id = nextId.fetch_add(1, std::memory_order::relaxed);
+    return id;
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_sharded_miniram<SizeType, IndexType>::tryAllocate(
+    shard& target,
+    size_t shard_index,
+    size_type size
+) -> alloc_type {
+    auto const local = target.ram.allocate(size);
+    if(local.id == INVALID_INDEX)
+        return local;
+
+    return toGlobal(shard_index, local);
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_sharded_miniram<SizeType, IndexType>::toGlobal(size_t shard_index, alloc_type local) const
+    -> alloc_type {
+    return {.offset = local.offset + _shards[shard_index]->base, .id = encodeId(shard_index, local.id)};
+}
+
+template<uint SizeType, uint IndexType>
+auto basic_sharded_miniram<SizeType, IndexType>::encodeId(size_t shard_index, index_type local_id) const
+    -> index_type {
+    CTH_CRITICAL(local_id >= (INVALID_INDEX >> _shardBits), "shard node index overflow") {}
+
+    return static_cast<index_type>((local_id << _shardBits) | static_cast<index_type>(shard_index));
+}
+
+}
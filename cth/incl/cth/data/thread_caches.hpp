@@ -0,0 +1,166 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace cth::dt::dev {
+
+/**
+ * per thread lookup of the caches of all live @ref thread_caches, shared by all cache types
+ */
+struct thread_cache_directory {
+    std::mutex mutex{};
+    // registry id -> cache, live registries only
+    std::vector<std::pair<size_t, void*>> caches{};
+
+    /**
+     * the calling thread's directory, registries keep a weak reference to reach it
+     */
+    [[nodiscard]] static std::shared_ptr<thread_cache_directory> const& local();
+
+    /**
+     * last cache the calling thread looked up, hit on every call if the thread works with a single registry
+     * @note may name a destroyed registry, ids are never reused so it never matches again
+     */
+    [[nodiscard]] static std::pair<size_t, void*>& last();
+
+    [[nodiscard]] static size_t next_id();
+};
+
+/**
+ * per thread caches of a thread safe container
+ * @details
+ * - a thread gets its cache on first use, later lookups of the same registry need no synchronization
+ * - caches live as long as the registry, caches of exited threads are kept
+ * - destroying the registry removes its caches from the lookups of all threads
+ * @tparam Cache per thread state, default constructible
+ * @note destruction must not run concurrently with lookups of the same registry
+ */
+template<class Cache>
+class thread_caches {
+public:
+    thread_caches() : _id{thread_cache_directory::next_id()} {}
+    ~thread_caches();
+
+    /**
+     * the calling thread's cache
+     * @param init called with a new cache before its first use
+     */
+    template<class Init>
+    [[nodiscard]] Cache& local(Init const& init);
+
+    /**
+     * calls fn(Cache&) for every cache
+     * @note must not run concurrently with the owning threads using their caches
+     */
+    template<class Fn>
+    void for_each(Fn const& fn);
+
+private:
+    template<class Init>
+    [[nodiscard]] Cache& registerCache(Init const& init);
+
+    struct entry {
+        std::unique_ptr<Cache> cache;
+        std::weak_ptr<thread_cache_directory> directory;
+    };
+
+    size_t _id;
+
+    std::mutex _mutex{};
+    std::vector<entry> _caches{};
+
+public:
+    thread_caches(thread_caches const& other) = delete;
+    thread_caches(thread_caches&& other) = delete;
+    thread_caches& operator=(thread_caches const& other) = delete;
+    thread_caches& operator=(thread_caches&& other) = delete;
+};
+
+}
+
+namespace cth::dt::dev {
+
+inline std::shared_ptr<thread_cache_directory> const& thread_cache_directory::local() {
+    thread_local auto const directory = std::make_shared<thread_cache_directory>();
+    return directory;
+}
+
+inline std::pair<size_t, void*>& thread_cache_directory::last() {
+    thread_local std::pair<size_t, void*> cached{0, nullptr};
+    return cached;
+}
+
+inline size_t thread_cache_directory::next_id() {
+    // ids are never reused, stale thread local lookups can't match a new registry
+    static std::atomic<size_t> nextId{1};
+    return nextId.fetch_add(1, std::memory_order::relaxed);
+}
+
+template<class Cache>
+thread_caches<Cache>::~thread_caches() {
+    for(auto const& [cache, weakDirectory] : _caches) {
+        // the thread exited, its directory is gone with it
+        auto const directory = weakDirectory.lock();
+        if(directory == nullptr)
+            continue;
+
+        std::scoped_lock lock{directory->mutex};
+        std::erase_if(directory->caches, [this](auto const& known) { return known.first == _id; });
+    }
+}
+
+template<class Cache>
+template<class Init>
+Cache& thread_caches<Cache>::local(Init const& init) {
+    auto& last = thread_cache_directory::last();
+
+    if(last.first == _id) [[likely]]
+        return *static_cast<Cache*>(last.second);
+
+    auto& cache = registerCache(init);
+    last = {_id, &cache};
+    return cache;
+}
+
+template<class Cache>
+template<class Fn>
+void thread_caches<Cache>::for_each(Fn const& fn) {
+    std::scoped_lock lock{_mutex};
+
+    for(auto const& e : _caches)
+        fn(*e.cache);
+}
+
+template<class Cache>
+template<class Init>
+Cache& thread_caches<Cache>::registerCache(Init const& init) {
+    auto const& directory = thread_cache_directory::local();
+
+    {
+        std::scoped_lock lock{directory->mutex};
+        for(auto const& [id, cache] : directory->caches)
+            if(id == _id)
+                return *static_cast<Cache*>(cache);
+    }
+
+    auto cache = std::make_unique<Cache>();
+    init(*cache);
+
+    auto* const result = cache.get();
+    {
+        std::scoped_lock lock{_mutex};
+        _caches.push_back({std::move(cache), directory});
+    }
+    {
+        std::scoped_lock lock{directory->mutex};
+        directory->caches.emplace_back(_id, result);
+    }
+
+    return *result;
+}
+
+}
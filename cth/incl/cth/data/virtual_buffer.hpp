@@ -0,0 +1,202 @@
+#pragma once
+#include "cth/io/log.hpp"
+#include "cth/os/osdef.hpp"
+
+#include <cstddef>
+#include <utility>
+
+#ifdef CTH_PLATFORM_WINDOWS
+// the header is public, min / max macros would break std::max and numeric_limits<>::max in includers
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cth::dt {
+
+/**
+ * page granular byte buffer in a reserved virtual address range
+ * @details
+ * - the whole range is reserved up front (no physical memory), its address never changes
+ * - a prefix of the range is committed on demand via @ref commit()
+ * - @ref decommit() returns the pages past a size to the os, the range stays reserved
+ */
+class virtual_buffer {
+public:
+    /**
+     * lower bound of the page size, the alignment of @ref data() is at least this
+     */
+    static constexpr size_t MIN_PAGE_SIZE = 4096;
+
+    virtual_buffer() = default;
+
+    /**
+     * reserves the address range
+     * @param reserved_bytes size of the range, rounded up to pages
+     * @throws cth::except::default_exception if the reservation fails
+     */
+    explicit virtual_buffer(size_t reserved_bytes);
+    ~virtual_buffer() { release(); }
+
+    /**
+     * commits the range prefix [0, bytes), no-op for the already committed part
+     * @param bytes <= @ref reserved(), rounded up to pages
+     * @throws cth::except::default_exception if the commit fails
+     */
+    void commit(size_t bytes);
+
+    /**
+     * decommits the pages after bytes, their content is lost
+     * @param bytes to keep committed, rounded up to pages
+     */
+    void decommit(size_t bytes);
+
+    /**
+     * size of a page in bytes
+     */
+    [[nodiscard]] static size_t page_size();
+
+private:
+    void release();
+
+    [[nodiscard]] static size_t roundToPages(size_t bytes) {
+        auto const page = page_size();
+        return (bytes + page - 1) / page * page;
+    }
+
+    std::byte* _data = nullptr;
+    size_t _reserved = 0;
+    size_t _committed = 0;
+
+public:
+    [[nodiscard]] std::byte* data() const { return _data; }
+    /**
+     * size of the reserved range in bytes
+     */
+    [[nodiscard]] size_t reserved() const { return _reserved; }
+    /**
+     * size of the committed prefix in bytes
+     */
+    [[nodiscard]] size_t committed() const { return _committed; }
+
+    virtual_buffer(virtual_buffer const& other) = delete;
+    virtual_buffer& operator=(virtual_buffer const& other) = delete;
+    virtual_buffer(virtual_buffer&& other) noexcept :
+        _data{std::exchange(other._data, nullptr)},
+        _reserved{std::exchange(other._reserved, 0)},
+        _committed{std::exchange(other._committed, 0)} {}
+    virtual_buffer& operator=(virtual_buffer&& other) noexcept {
+        if(&other == this)
+            return *this;
+
+        release();
+        _data = std::exchange(other._data, nullptr);
+        _reserved = std::exchange(other._reserved, 0);
+        _committed = std::exchange(other._committed, 0);
+        return *this;
+    }
+};
+
+}
+
+namespace cth::dt {
+
+inline virtual_buffer::virtual_buffer(size_t reserved_bytes) : _reserved{roundToPages(reserved_bytes)} {
+    if(_reserved == 0)
+        return;
+
+#ifdef CTH_PLATFORM_WINDOWS
+    void* const ptr = VirtualAlloc(nullptr, _reserved, MEM_RESERVE, PAGE_NOACCESS);
+    bool const failed = ptr == nullptr;
+#else
+    void* const ptr = mmap(nullptr, _reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    bool const failed = ptr == MAP_FAILED;
+#endif
+
+    CTH_STABLE_ERR(failed, "failed to reserve virtual memory") {
+        details->add("bytes: {}", _reserved);
+        throw details->exception();
+    }
+
+    _data = static_cast<std::byte*>(ptr);
+}
+
+inline void virtual_buffer::commit(size_t bytes) {
+    CTH_CRITICAL(bytes > _reserved, "commit exceeds the reserved range") {}
+
+    auto const target = roundToPages(bytes);
+    if(target <= _committed)
+        return;
+
+    auto* const begin = _data + _committed;
+    auto const size = target - _committed;
+
+#ifdef CTH_PLATFORM_WINDOWS
+    bool const failed = VirtualAlloc(begin, size, MEM_COMMIT, PAGE_READWRITE) == nullptr;
+#else
+    bool const failed = mprotect(begin, size, PROT_READ | PROT_WRITE) != 0;
+#endif
+
+    CTH_STABLE_ERR(failed, "failed to commit virtual memory") {
+        details->add("bytes: {}", target);
+        throw details->exception();
+    }
+
+    _committed = target;
+}
+
+inline void virtual_buffer::decommit(size_t bytes) {
+    auto const target = roundToPages(bytes);
+    if(target >= _committed)
+        return;
+
+    auto* const begin = _data + target;
+    auto const size = _committed - target;
+
+#ifdef CTH_PLATFORM_WINDOWS
+    VirtualFree(begin, size, MEM_DECOMMIT);
+#else
+    // drop the pages first, protecting alone keeps them resident
+    madvise(begin, size, MADV_DONTNEED);
+    mprotect(begin, size, PROT_NONE);
+#endif
+
+    _committed = target;
+}
+
+inline size_t virtual_buffer::page_size() {
+#ifdef CTH_PLATFORM_WINDOWS
+    static size_t const pageSize = [] {
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwPageSize);
+    }();
+#else
+    static size_t const pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    return pageSize;
+}
+
+inline void virtual_buffer::release() {
+    if(_data == nullptr)
+        return;
+
+#ifdef CTH_PLATFORM_WINDOWS
+    VirtualFree(_data, 0, MEM_RELEASE);
+#else
+    munmap(_data, _reserved);
+#endif
+
+    _data = nullptr;
+    _reserved = 0;
+    _committed = 0;
+}
+
+}
@@ -0,0 +1,107 @@
+#include "cth/data/cached_miniram.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+
+namespace cth::dt {
+
+DATA_TEST(cached_miniram, reuses_freed_blocks) {
+    cached_miniram ram(4096, 1, 4, 16);
+
+    auto const a = ram.allocate(100);
+    ASSERT_NE(a.id, cached_miniram::INVALID_INDEX);
+    EXPECT_EQ(ram.size_of(a), 112);
+
+    ram.free(a, 100);
+    EXPECT_EQ(ram.allocated(), 112);
+
+    // same size class, served from the magazine
+    auto const b = ram.allocate(99);
+    EXPECT_EQ(b.offset, a.offset);
+    EXPECT_EQ(b.id, a.id);
+
+    ram.free(b, 99);
+    ram.flush();
+    EXPECT_EQ(ram.allocated(), 0);
+}
+
+DATA_TEST(cached_miniram, size_classes) {
+    cached_miniram ram(1024 * 1024, 1, 4, 16);
+
+    for(size_t size = 1; size <= cached_miniram::MAX_CACHED_SIZE; ++size) {
+        auto const alloc = ram.allocate(size);
+        auto const classSize = ram.size_of(alloc);
+
+        EXPECT_GE(classSize, size);
+        // at most 25% rounding overhead past the exact classes
+        EXPECT_LE(classSize, std::max<size_t>(size + size / 4, 8));
+
+        ram.free(alloc, size);
+    }
+}
+
+DATA_TEST(cached_miniram, large_blocks_bypass_the_cache) {
+    cached_miniram ram(4096, 1, 4, 16);
+
+    auto const a = ram.allocate(1000);
+    EXPECT_EQ(ram.size_of(a), 1000);
+
+    ram.free(a, 1000);
+    EXPECT_EQ(ram.allocated(), 0);
+}
+
+DATA_TEST(cached_miniram, overflow_flushes_half) {
+    cached_miniram ram(4096, 1, 4, 16);
+
+    std::vector<mini_alloc> allocations{};
+    for(int i = 0; i < 5; ++i)
+        allocations.push_back(ram.allocate(16));
+
+    for(auto const& alloc : allocations)
+        ram.free(alloc, 16);
+
+    // 4 cached, the 5th free flushed 2
+    EXPECT_EQ(ram.allocated(), 3 * 16);
+
+    ram.flush();
+    EXPECT_EQ(ram.allocated(), 0);
+}
+
+DATA_TEST(cached_miniram, concurrent_no_overlap) {
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr size_t ROUNDS = 200;
+    constexpr size_t ALLOCS_PER_ROUND = 16;
+
+    cached_miniram ram(1024 * 1024, 4, 8, 64);
+
+    {
+        std::vector<std::jthread> threads;
+        for(size_t t = 0; t < THREAD_COUNT; ++t)
+            threads.emplace_back([&ram, t] {
+                std::vector<std::pair<mini_alloc, uint32_t>> live{};
+                for(size_t round = 0; round < ROUNDS; ++round) {
+                    for(size_t i = 0; i < ALLOCS_PER_ROUND; ++i) {
+                        auto const size = static_cast<uint32_t>(1 + (t * 31 + round * 7 + i) % 256);
+                        auto const alloc = ram.allocate(size);
+                        ASSERT_NE(alloc.id, cached_miniram::INVALID_INDEX);
+                        live.emplace_back(alloc, size);
+                    }
+
+                    for(size_t i = round % 2; i < live.size(); i += 2)
+                        ram.free(live[i].first, live[i].second);
+                    std::erase_if(live, [&, i = size_t{0}](auto const&) mutable { return i++ % 2 == round % 2; });
+                }
+
+                for(auto const& [alloc, size] : live)
+                    ram.free(alloc, size);
+            });
+    }
+
+    ram.flush_all();
+    EXPECT_EQ(ram.remaining(), ram.capacity());
+}
+
+}
@@ -0,0 +1,209 @@
+#include "cth/data/concurrent_pool.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace cth::dt {
+
+namespace {
+    struct counted {
+        int value;
+        std::atomic<int> owners{0};
+
+        explicit counted(int v) : value(v) {}
+    };
+
+    struct value_resetter {
+        void reset(counted& c) { c.value = 0; }
+    };
+}
+
+DATA_TEST(concurrent_pool, acquire_release_reuse) {
+    concurrent_pool<std::string> p;
+    EXPECT_EQ(p.capacity(), 0);
+    EXPECT_EQ(p.try_acquire(), nullptr);
+
+    p.emplace("Hello");
+    EXPECT_EQ(p.capacity(), 1);
+
+    auto& s = p.acquire();
+    EXPECT_EQ(s, "Hello");
+    EXPECT_EQ(p.try_acquire(), nullptr);
+
+    s = "World";
+    p.release(s);
+
+    // default manipulator, state persists
+    auto& s2 = p.acquire();
+    EXPECT_EQ(&s, &s2);
+    EXPECT_EQ(s2, "World");
+}
+
+DATA_TEST(concurrent_pool, reset_on_release) {
+    concurrent_pool<counted, value_resetter> p;
+    p.emplace(42);
+
+    auto& c = p.acquire();
+    EXPECT_EQ(c.value, 42);
+
+    c.value = 99;
+    p.release(c);
+
+    EXPECT_EQ(p.acquire().value, 0);
+}
+
+DATA_TEST(concurrent_pool, lease_releases_on_destruction) {
+    concurrent_pool<counted, value_resetter> p;
+    p.emplace(42);
+
+    {
+        auto leased = p.acquire_lease();
+        EXPECT_EQ(leased->value, 42);
+        EXPECT_EQ(p.try_acquire(), nullptr);
+    }
+
+    EXPECT_EQ(p.acquire().value, 0);
+}
+
+DATA_TEST(concurrent_pool, acquire_or_emplace_grows) {
+    concurrent_pool<int> p;
+
+    std::set<int*> acquired{};
+    for(int i = 0; i < 1'000; ++i)
+        acquired.insert(&p.acquire_or_emplace(i));
+
+    // spans several chunks, instances stay in place
+    EXPECT_EQ(acquired.size(), 1'000);
+    EXPECT_EQ(p.capacity(), 1'000);
+    EXPECT_EQ(p.try_acquire(), nullptr);
+
+    for(auto* i : acquired)
+        p.release(*i);
+
+    // released instances are reused before constructing new ones
+    EXPECT_TRUE(acquired.contains(&p.acquire_or_emplace(0)));
+    EXPECT_EQ(p.capacity(), 1'000);
+}
+
+DATA_TEST(concurrent_pool, caches_flush_to_other_threads) {
+    concurrent_pool<int> p{4};
+    for(int i = 0; i < 8; ++i)
+        p.emplace(i);
+
+    std::vector<int*> acquired{};
+    while(auto* i = p.try_acquire())
+        acquired.push_back(i);
+    EXPECT_EQ(acquired.size(), 8);
+
+    // a full cache moves half of it to the global stack
+    for(auto* i : acquired)
+        p.release(*i);
+
+    size_t otherThread = 0;
+    std::jthread{[&] {
+        while(p.try_acquire() != nullptr)
+            ++otherThread;
+    }}.join();
+    EXPECT_EQ(otherThread, 4);
+
+    p.flush();
+    std::jthread{[&] {
+        while(p.try_acquire() != nullptr)
+            ++otherThread;
+    }}.join();
+    EXPECT_EQ(otherThread, 8);
+}
+
+DATA_TEST(concurrent_pool, flush_all_and_clear) {
+    concurrent_pool<counted, value_resetter> p;
+    for(int i = 1; i <= 16; ++i)
+        p.emplace(i);
+
+    // instances acquired and released by an exited thread stay in its cache
+    std::jthread{[&p] {
+        std::vector<counted*> acquired{};
+        while(auto* c = p.try_acquire())
+            acquired.push_back(c);
+        for(auto* c : acquired)
+            p.release(*c);
+    }}.join();
+    EXPECT_EQ(p.try_acquire(), nullptr);
+
+    p.flush_all();
+    auto& c = p.acquire();
+    c.value = 7;
+
+    p.clear();
+
+    size_t count = 0;
+    while(auto* cleared = p.try_acquire()) {
+        EXPECT_EQ(cleared->value, 0);
+        ++count;
+    }
+    EXPECT_EQ(count, 16);
+}
+
+DATA_TEST(concurrent_pool, concurrent_exclusive_ownership) {
+    constexpr size_t threadCount = 8;
+    constexpr size_t iterations = 20'000;
+
+    concurrent_pool<counted> p{8};
+    for(int i = 0; i < 64; ++i)
+        p.emplace(i);
+
+    std::atomic<bool> shared{false};
+    {
+        std::vector<std::jthread> threads;
+        for(size_t t = 0; t < threadCount; ++t)
+            threads.emplace_back([&p, &shared, t] {
+                std::vector<counted*> held{};
+                for(size_t i = 0; i < iterations; ++i) {
+                    auto* c = (i + t) % 3 == 0 ? &p.acquire_or_emplace(0) : p.try_acquire();
+                    if(c != nullptr) {
+                        if(c->owners.fetch_add(1) != 0)
+                            shared = true;
+                        held.push_back(c);
+                    }
+
+                    if(held.size() > 4 || (c == nullptr && !held.empty())) {
+                        held.front()->owners.fetch_sub(1);
+                        p.release(*held.front());
+                        held.erase(held.begin());
+                    }
+                }
+
+                for(auto* c : held) {
+                    c->owners.fetch_sub(1);
+                    p.release(*c);
+                }
+            });
+    }
+    EXPECT_FALSE(shared);
+
+    p.flush_all();
+
+    std::set<counted*> all{};
+    while(auto* c = p.try_acquire())
+        all.insert(c);
+    EXPECT_EQ(all.size(), p.capacity());
+}
+
+#ifdef _DEBUG
+DATA_TEST(concurrent_pool, double_release_crash) {
+    concurrent_pool<int> p;
+    p.emplace(1);
+
+    auto& value = p.acquire();
+    p.release(value);
+
+    ASSERT_DEATH(p.release(value), ".*");
+}
+#endif
+
+}
@@ -0,0 +1,135 @@
+#include "cth/data/lifetime_miniram.hpp"
+#include "test.hpp"
+
+#include <limits>
+#include <random>
+#include <vector>
+
+
+namespace cth::dt {
+
+DATA_TEST(lifetime_miniram, segregates_lifetimes) {
+    lifetime_miniram ram(1024, 16);
+
+    auto const resident = ram.allocate(100);
+    ASSERT_NE(resident.id, lifetime_miniram::INVALID_INDEX);
+    EXPECT_EQ(resident.offset, 0);
+
+    auto const transient = ram.allocate_transient(100);
+    EXPECT_EQ(transient, 1024 - 100);
+
+    auto const aligned = ram.allocate_transient(10, 64);
+    EXPECT_EQ(aligned % 64, 0);
+    EXPECT_LE(aligned + 10, transient);
+
+    EXPECT_EQ(ram.resident_allocated(), 100);
+    EXPECT_EQ(ram.transient_allocated(), 1024 - aligned);
+    EXPECT_EQ(ram.allocated(), ram.resident_allocated() + ram.transient_allocated());
+
+    ram.free_transient();
+    EXPECT_EQ(ram.transient_allocated(), 0);
+    EXPECT_EQ(ram.allocated(), 100);
+
+    ram.free(resident);
+    EXPECT_EQ(ram.allocated(), 0);
+}
+
+DATA_TEST(lifetime_miniram, rewind_transient) {
+    lifetime_miniram ram(1024, 16);
+
+    static_cast<void>(ram.allocate_transient(100));
+    auto const marker = ram.transient_marker();
+
+    static_cast<void>(ram.allocate_transient(200));
+    static_cast<void>(ram.allocate_transient(300));
+    EXPECT_EQ(ram.transient_allocated(), 600);
+
+    ram.rewind_transient(marker);
+    EXPECT_EQ(ram.transient_allocated(), 100);
+    EXPECT_EQ(ram.allocate_transient(200), marker - 200);
+}
+
+DATA_TEST(lifetime_miniram, regions_meet) {
+    lifetime_miniram ram(1024, 16);
+
+    // transient takes everything, resident can't grow
+    EXPECT_EQ(ram.allocate_transient(1024), 0);
+    EXPECT_EQ(ram.allocate(1).id, lifetime_miniram::INVALID_INDEX);
+    EXPECT_EQ(ram.allocate_transient(1), lifetime_miniram::NO_SPACE);
+
+    ram.free_transient();
+
+    // resident blocks block the transient stack, only the free resident tail is given up
+    auto const resident = ram.allocate(512);
+    ASSERT_NE(resident.id, lifetime_miniram::INVALID_INDEX);
+    EXPECT_EQ(ram.allocate_transient(1024 - 511), lifetime_miniram::NO_SPACE);
+    EXPECT_EQ(ram.allocate_transient(512), 512);
+    EXPECT_EQ(ram.resident_capacity(), 512);
+
+    ram.free_transient();
+    ram.free(resident);
+
+    auto const big = ram.allocate(1000);
+    EXPECT_NE(big.id, lifetime_miniram::INVALID_INDEX);
+}
+
+DATA_TEST(lifetime_miniram, degenerate_requests_terminate) {
+    {
+        // the empty resident region must still grow on a failed zero sized request
+        lifetime_miniram32 ram(1024, 8);
+        static_cast<void>(ram.allocate(0));
+        static_cast<void>(ram.allocate(0));
+        EXPECT_LE(ram.resident_capacity(), ram.capacity());
+    }
+
+    lifetime_miniram32 ram(1024, 8);
+    auto constexpr maxSize = std::numeric_limits<uint32_t>::max();
+
+    // padding would wrap, the requests can't fit either way
+    EXPECT_EQ(ram.allocate(maxSize).id, lifetime_miniram32::INVALID_INDEX);
+    EXPECT_EQ(ram.allocate(maxSize - 10, 64).id, lifetime_miniram32::INVALID_INDEX);
+    EXPECT_EQ(ram.allocate(maxSize / 2 + 1).id, lifetime_miniram32::INVALID_INDEX);
+
+    auto const fits = ram.allocate(100, 64);
+    ASSERT_NE(fits.id, lifetime_miniram32::INVALID_INDEX);
+    EXPECT_EQ(fits.offset % 64, 0);
+}
+
+DATA_TEST(lifetime_miniram, frame_churn) {
+    lifetime_miniram ram(1024 * 1024, 64);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> sizeDist(1, 1024);
+
+    std::vector<mini_alloc> residents{};
+
+    for(size_t frame = 0; frame < 200; ++frame) {
+        for(size_t i = 0; i < 50; ++i)
+            ASSERT_NE(ram.allocate_transient(sizeDist(gen)), lifetime_miniram::NO_SPACE);
+
+        if(frame % 4 == 0) {
+            auto const alloc = ram.allocate(sizeDist(gen));
+            ASSERT_NE(alloc.id, lifetime_miniram::INVALID_INDEX);
+            EXPECT_LT(alloc.offset + ram.size_of(alloc), ram.transient_marker() + 1);
+            residents.push_back(alloc);
+        }
+        if(frame % 12 == 0 && !residents.empty()) {
+            ram.free(residents.front());
+            residents.erase(residents.begin());
+        }
+
+        ram.free_transient();
+    }
+
+    size_t residentSize = 0;
+    for(auto const& alloc : residents)
+        residentSize += ram.size_of(alloc);
+
+    EXPECT_EQ(ram.resident_allocated(), residentSize);
+    EXPECT_EQ(ram.transient_allocated(), 0);
+
+    auto const report = ram.defragment();
+    EXPECT_EQ(report.updatedAllocs.size(), residents.size());
+}
+
+}
@@ -0,0 +1,158 @@
+#include "cth/data/mini_mover.hpp"
+#include "test.hpp"
+
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <random>
+#include <vector>
+
+
+namespace cth::dt {
+
+namespace {
+    /**
+     * reference, executes the moves one after another
+     */
+    void sequential_moves(std::span<mini_memmove const> moves, std::vector<uint32_t>& memory) {
+        for(auto const& move : moves)
+            std::memmove(&memory[move.dstOffset], &memory[move.srcOffset], move.size * sizeof(uint32_t));
+    }
+
+    std::vector<uint32_t> iota_memory(size_t size) {
+        std::vector<uint32_t> memory(size);
+        std::iota(memory.begin(), memory.end(), 0u);
+        return memory;
+    }
+}
+
+DATA_TEST(mini_mover, construction) {
+    mini_mover const mover{0, 16, 0};
+
+    EXPECT_EQ(mover.thread_count(), 1);
+    EXPECT_EQ(mover.parallel_threshold(), 16);
+    EXPECT_EQ(mover.block_size(), 1);
+}
+
+DATA_TEST(mini_mover, disjoint_moves) {
+    std::vector<mini_memmove> const moves{{100, 0, 50}, {300, 50, 100}, {600, 400, 150}};
+
+    auto expected = iota_memory(1024);
+    sequential_moves(moves, expected);
+
+    auto memory = iota_memory(1024);
+    mini_mover{4, 0, 16}.execute(std::span<mini_memmove const>{moves}, memory.data(), sizeof(uint32_t));
+
+    EXPECT_EQ(memory, expected);
+}
+
+DATA_TEST(mini_mover, overlapping_chains) {
+    // each move overwrites the source of its predecessor / itself
+    std::vector<mini_memmove> const moves{{10, 0, 100}, {120, 100, 300}, {430, 400, 20}, {900, 420, 50}};
+
+    auto expected = iota_memory(1024);
+    sequential_moves(moves, expected);
+
+    auto memory = iota_memory(1024);
+    mini_mover{4, 0, 8}.execute(std::span<mini_memmove const>{moves}, memory.data(), sizeof(uint32_t));
+
+    EXPECT_EQ(memory, expected);
+}
+
+DATA_TEST(mini_mover, disjoint_compaction_runs_in_parallel) {
+    // left compaction, every destination lies below the previous source end
+    std::vector<mini_memmove> const moves{{100, 0, 50}, {200, 50, 10}, {400, 60, 30}, {700, 90, 10}};
+
+    auto expected = iota_memory(1024);
+    sequential_moves(moves, expected);
+
+    auto memory = iota_memory(1024);
+    auto const result =
+        mini_mover{4, 0, 16}.execute(std::span<mini_memmove const>{moves}, memory.data(), sizeof(uint32_t));
+
+    EXPECT_EQ(memory, expected);
+    EXPECT_EQ(result.batches, 1);
+    EXPECT_EQ(result.parallelBatches, 1);
+}
+
+DATA_TEST(mini_mover, dependent_moves_split_batches) {
+    // the second move reads what the first one writes, the third overwrites the second source
+    std::vector<mini_memmove> const moves{{100, 0, 50}, {20, 200, 10}, {500, 25, 10}};
+
+    auto expected = iota_memory(1024);
+    sequential_moves(moves, expected);
+
+    auto memory = iota_memory(1024);
+    auto const result =
+        mini_mover{4, 0, 16}.execute(std::span<mini_memmove const>{moves}, memory.data(), sizeof(uint32_t));
+
+    EXPECT_EQ(memory, expected);
+    EXPECT_EQ(result.batches, 3);
+}
+
+DATA_TEST(mini_mover, random_moves_match_sequential) {
+    constexpr size_t size = 4096;
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<uint32_t> offsetDist(0, size - 256);
+    std::uniform_int_distribution<uint32_t> sizeDist(1, 256);
+
+    mini_mover const mover{4, 0, 32};
+
+    for(size_t round = 0; round < 200; ++round) {
+        std::vector<mini_memmove> moves{};
+        for(size_t i = 0; i < 16; ++i)
+            moves.emplace_back(offsetDist(gen), offsetDist(gen), sizeDist(gen));
+
+        auto expected = iota_memory(size);
+        sequential_moves(moves, expected);
+
+        auto memory = iota_memory(size);
+        mover.execute(std::span<mini_memmove const>{moves}, memory.data(), sizeof(uint32_t));
+
+        ASSERT_EQ(memory, expected);
+    }
+}
+
+DATA_TEST(mini_mover, defragmentation_report) {
+    constexpr size_t capacity = 256 * 1024;
+
+    miniram ram(capacity);
+    std::vector<uint32_t> memory(capacity, 0);
+    std::map<miniram::index_type, std::pair<mini_alloc, uint32_t>> live;
+
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<size_t> sizeDist(1, 2048);
+
+    for(uint32_t tag = 1; tag < 400; ++tag) {
+        auto const alloc = ram.allocate(sizeDist(gen));
+        if(alloc.id == miniram::INVALID_INDEX)
+            break;
+
+        std::fill_n(memory.begin() + alloc.offset, ram.size_of(alloc), tag);
+        live[alloc.id] = {alloc, tag};
+    }
+
+    for(auto it = live.begin(); it != live.end();) {
+        if(gen() % 2 == 0) {
+            ram.free(it->second.first);
+            it = live.erase(it);
+        } else
+            ++it;
+    }
+
+    auto const report = ram.defragment();
+
+    mini_mover{4, 1024, 256}.execute(report, memory.data(), sizeof(uint32_t));
+
+    for(auto const& updated : report.updatedAllocs)
+        live[updated.id].first.offset = updated.offset;
+
+    for(auto const& [alloc, tag] : live | std::views::values) {
+        auto const size = ram.size_of(alloc);
+        for(size_t i = 0; i < size; ++i)
+            ASSERT_EQ(memory[alloc.offset + i], tag);
+    }
+}
+
+}
@@ -0,0 +1,159 @@
+#include "cth/data/mini_trace.hpp"
+#include "test.hpp"
+
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+namespace cth::dt {
+
+namespace {
+    /**
+     * random session with every recorded call
+     * @return elements moved by the session
+     */
+    uint64_t record_session(mini_recorder<miniram>& recorder) {
+        std::mt19937 gen(1337);
+        std::uniform_int_distribution<size_t> sizeDist(1, 512);
+        std::uniform_int_distribution<int> opDist(0, 99);
+
+        std::vector<mini_alloc> live{};
+        uint64_t moved = 0;
+
+        auto const apply = [&](auto const& report) {
+            for(auto const& alloc : report.updatedAllocs)
+                for(auto& liveAlloc : live)
+                    if(liveAlloc.id == alloc.id)
+                        liveAlloc = alloc;
+            for(auto const& move : report.moves)
+                moved += move.size;
+        };
+
+        for(size_t i = 0; i < 2000; ++i) {
+            auto const op = opDist(gen);
+
+            if(op < 50) {
+                auto const size = sizeDist(gen);
+                auto const alloc = op < 45 ? recorder.allocate(size) : recorder.allocate(size, 64);
+                if(alloc.id != miniram::INVALID_INDEX)
+                    live.push_back(alloc);
+            } else if(op < 95 && !live.empty()) {
+                std::uniform_int_distribution<size_t> indexDist(0, live.size() - 1);
+                auto const index = indexDist(gen);
+
+                recorder.free(live[index]);
+                live[index] = live.back();
+                live.pop_back();
+            } else if(op < 98) {
+                apply(recorder.defragment_step(256).report);
+            } else {
+                apply(recorder.defragment());
+            }
+        }
+
+        recorder.free_n(live);
+        return moved;
+    }
+}
+
+DATA_TEST(mini_trace, record_serialize_replay) {
+    mini_recorder<miniram> recorder{64 * 1024, 16};
+    auto const moved = record_session(recorder);
+    EXPECT_TRUE(recorder.ram().empty());
+
+    auto const& trace = recorder.trace();
+    EXPECT_EQ(trace.capacity, 64 * 1024);
+    EXPECT_GT(trace.allocations, 0);
+
+    auto const restored = mini_trace::deserialize(trace.serialize());
+    ASSERT_EQ(restored.events.size(), trace.events.size());
+    EXPECT_EQ(restored.allocations, trace.allocations);
+
+    // the same configuration replays the recording exactly
+    auto const report = mini_replay<miniram>(restored, 16);
+    EXPECT_EQ(report.movedElements, moved);
+    EXPECT_EQ(report.failedAllocs, 0);
+    EXPECT_EQ(report.allocate.count, trace.allocations);
+    EXPECT_EQ(report.free.count, trace.allocations);
+    EXPECT_EQ(report.all.count, trace.events.size());
+    EXPECT_GT(report.peakFragmentation, 0.0f);
+    EXPECT_LE(report.all.p50, report.all.p99);
+    EXPECT_LE(report.all.p99, report.all.max);
+
+    auto const soa = mini_replay<miniram_soa>(restored, 16);
+    EXPECT_EQ(soa.movedElements, moved);
+
+    using lowest_miniram =
+        basic_miniram<size_t, uint32_t, mini_config{.placement = MiniPlacement::LOWEST_ADDRESS}>;
+    auto const lowest = mini_replay<lowest_miniram>(restored, 16);
+    EXPECT_EQ(lowest.all.count, trace.events.size());
+}
+
+DATA_TEST(mini_trace, deserialize_rejects_garbage) {
+    mini_recorder<miniram> recorder{1024, 16};
+    recorder.free(recorder.allocate(10));
+
+    auto const blob = recorder.trace().serialize();
+    EXPECT_ANY_THROW(static_cast<void>(mini_trace::deserialize(std::span{blob}.first(blob.size() - 1))));
+
+    auto garbage = blob;
+    garbage[0] = std::byte{0};
+    EXPECT_ANY_THROW(static_cast<void>(mini_trace::deserialize(garbage)));
+}
+
+DATA_TEST(mini_trace, deserialize_rejects_inconsistent_traces) {
+    mini_recorder<miniram> recorder{1024, 16};
+    auto const a = recorder.allocate(10, 16);
+    recorder.free(a);
+
+    auto const trace = recorder.trace();
+    ASSERT_EQ(trace.inconsistency(), nullptr);
+
+    auto const rejected = [](mini_trace const& corrupted) {
+        bool const replayThrows = [&] {
+            try {
+                static_cast<void>(mini_replay<miniram>(corrupted, 16));
+            } catch(...) { return true; }
+            return false;
+        }();
+
+        try {
+            static_cast<void>(mini_trace::deserialize(corrupted.serialize()));
+        } catch(...) { return replayThrows; }
+        return false;
+    };
+
+    auto unknownOp = trace;
+    unknownOp.events[0].op = static_cast<MiniTraceOp>(42);
+    EXPECT_TRUE(rejected(unknownOp));
+
+    auto badAlignment = trace;
+    badAlignment.events[0].arg = 24;
+    EXPECT_TRUE(rejected(badAlignment));
+
+    auto zeroAlignment = trace;
+    zeroAlignment.events[0].arg = 0;
+    EXPECT_TRUE(rejected(zeroAlignment));
+
+    auto futureFree = trace;
+    futureFree.events[1].value = 1;
+    EXPECT_TRUE(rejected(futureFree));
+
+    auto freeFirst = trace;
+    std::swap(freeFirst.events[0], freeFirst.events[1]);
+    EXPECT_TRUE(rejected(freeFirst));
+
+    auto wrongCount = trace;
+    wrongCount.allocations = 0;
+    EXPECT_TRUE(rejected(wrongCount));
+
+    // an event count whose byte size overflows
+    auto blob = trace.serialize();
+    auto const forged = ~uint64_t{0} / 2;
+    std::memcpy(blob.data() + 3 * sizeof(uint64_t), &forged, sizeof(forged));
+    EXPECT_ANY_THROW(static_cast<void>(mini_trace::deserialize(blob)));
+}
+
+}
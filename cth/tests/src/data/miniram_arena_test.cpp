@@ -0,0 +1,174 @@
+#include "cth/data/miniram_arena.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+
+namespace cth::dt {
+
+DATA_TEST(miniram_arena, allocate_and_release) {
+    miniram_arena<uint32_t> arena{1024};
+
+    {
+        auto a = arena.allocate(100);
+        ASSERT_TRUE(a);
+        EXPECT_EQ(a.size(), 100);
+        EXPECT_EQ(a.span().size(), 100);
+        EXPECT_EQ(a.data(), arena.data() + a.offset());
+
+        std::ranges::fill(a.span(), 42u);
+        EXPECT_EQ(arena.allocated(), 100);
+    }
+
+    EXPECT_EQ(arena.remaining(), arena.capacity());
+}
+
+DATA_TEST(miniram_arena, aligned_buffer) {
+    miniram_arena<uint8_t> arena{4096};
+
+    auto const a = arena.allocate(3);
+    auto const b = arena.allocate(10, 64);
+
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.data()) % miniram_arena<uint8_t>::ALIGNMENT, 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b.data()) % 64, 0);
+}
+
+DATA_TEST(miniram_arena, handle_move) {
+    miniram_arena<uint32_t> arena{1024};
+
+    auto a = arena.allocate(10);
+    auto b = std::move(a);
+
+    EXPECT_FALSE(a);
+    EXPECT_TRUE(b);
+    EXPECT_EQ(a.data(), nullptr);
+
+    b = arena.allocate(20);
+    EXPECT_EQ(arena.allocated(), 20);
+
+    b.reset();
+    EXPECT_EQ(arena.allocated(), 0);
+}
+
+DATA_TEST(miniram_arena, defragment_patches_handles) {
+    miniram_arena<uint32_t> arena{1024, {.initialAllocCapacity = 16}};
+
+    std::vector<miniram_arena<uint32_t>::handle> handles{};
+    for(uint32_t i = 0; i < 16; ++i) {
+        handles.push_back(arena.allocate(64));
+        std::ranges::fill(handles.back().span(), i);
+    }
+
+    for(size_t i = 0; i < handles.size(); i += 2)
+        handles[i].reset();
+
+    EXPECT_TRUE(arena.defragment());
+
+    for(size_t i = 1; i < handles.size(); i += 2) {
+        EXPECT_EQ(handles[i].offset(), (i / 2) * 64);
+        EXPECT_TRUE(std::ranges::all_of(handles[i].span(), [i](uint32_t v) { return v == i; }));
+    }
+}
+
+DATA_TEST(miniram_arena, allocation_defragments_on_failure) {
+    miniram_arena<uint32_t> arena{1024, {.initialAllocCapacity = 16}};
+
+    std::vector<miniram_arena<uint32_t>::handle> handles{};
+    for(uint32_t i = 0; i < 8; ++i) {
+        handles.push_back(arena.allocate(128));
+        std::ranges::fill(handles.back().span(), i);
+    }
+
+    for(size_t i = 0; i < handles.size(); i += 2)
+        handles[i].reset();
+
+    // 512 elements are free, but not contiguous
+    auto big = arena.allocate(512);
+    ASSERT_TRUE(big);
+    EXPECT_EQ(big.offset(), 512);
+
+    for(size_t i = 1; i < handles.size(); i += 2)
+        EXPECT_TRUE(std::ranges::all_of(handles[i].span(), [i](uint32_t v) { return v == i; }));
+}
+
+DATA_TEST(miniram_arena, incremental_defragmentation) {
+    miniram_arena<uint32_t> arena{1024, {.initialAllocCapacity = 16}};
+
+    std::vector<miniram_arena<uint32_t>::handle> handles{};
+    for(uint32_t i = 0; i < 8; ++i) {
+        handles.push_back(arena.allocate(128));
+        std::ranges::fill(handles.back().span(), i);
+    }
+
+    for(size_t i = 0; i < handles.size(); i += 2)
+        handles[i].reset();
+
+    size_t steps = 1;
+    while(!arena.defragment_step(128))
+        ++steps;
+
+    EXPECT_GT(steps, 1);
+    for(size_t i = 1; i < handles.size(); i += 2) {
+        EXPECT_EQ(handles[i].offset(), (i / 2) * 128);
+        EXPECT_TRUE(std::ranges::all_of(handles[i].span(), [i](uint32_t v) { return v == i; }));
+    }
+}
+
+DATA_TEST(miniram_arena, memory_resource) {
+    miniram_arena<uint32_t> arena{4096};
+
+    {
+        std::pmr::vector<uint64_t> values{arena.resource()};
+        for(uint64_t i = 0; i < 100; ++i)
+            values.push_back(i);
+
+        EXPECT_TRUE(arena.pinned());
+        EXPECT_FALSE(arena.defragment());
+
+        auto* const begin = reinterpret_cast<uint32_t const*>(values.data());
+        EXPECT_GE(begin, arena.data());
+        EXPECT_LT(begin, arena.data() + arena.capacity());
+        EXPECT_EQ(values[99], 99);
+    }
+
+    EXPECT_FALSE(arena.pinned());
+    EXPECT_EQ(arena.allocated(), 0);
+
+    auto const tooBig = arena.capacity() * sizeof(uint32_t) + 1;
+    EXPECT_THROW(static_cast<void>(arena.resource()->allocate(tooBig)), std::bad_alloc);
+}
+
+DATA_TEST(miniram_arena, resize) {
+    miniram_arena<uint32_t> arena{1024, {.maxCapacity = 1024 * 1024, .initialAllocCapacity = 16}};
+
+    EXPECT_GE(arena.max_capacity(), 1024 * 1024);
+
+    auto a = arena.allocate(1024);
+    std::ranges::fill(a.span(), 7u);
+    auto* const before = a.data();
+
+    // grows in place, nothing moves
+    EXPECT_TRUE(arena.resize(64 * 1024));
+    EXPECT_EQ(arena.capacity(), 64 * 1024);
+    EXPECT_EQ(a.data(), before);
+
+    auto b = arena.allocate(32 * 1024);
+    ASSERT_TRUE(b);
+    std::ranges::fill(b.span(), 9u);
+
+    EXPECT_FALSE(arena.resize(arena.max_capacity() + 1));
+
+    // shrinking over a live tail compacts
+    a.reset();
+    EXPECT_TRUE(arena.resize(32 * 1024));
+    EXPECT_EQ(b.offset(), 0);
+    EXPECT_TRUE(std::ranges::all_of(b.span(), [](uint32_t v) { return v == 9; }));
+
+    EXPECT_FALSE(arena.resize(1024));
+    EXPECT_EQ(arena.capacity(), 32 * 1024);
+}
+
+}
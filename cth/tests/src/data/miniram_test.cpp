@@ -1,10 +1,14 @@
 #include "cth/data/miniram.hpp"
 #include "test.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <map>
 #include <random>
+#include <set>
 #include <vector>
 
 
@@ -128,6 +132,263 @@ DATA_TEST(miniram, zero_fragmentation_scenario) {
     EXPECT_EQ(validateAll.offset, 0);
 }
 
+DATA_TEST(miniram, batch_allocate) {
+    miniram ram(1024, 2);
+
+    std::vector<size_t> const sizes{100, 200, 300, 2000, 400};
+    auto const allocations = ram.allocate_n(sizes);
+
+    ASSERT_EQ(allocations.size(), sizes.size());
+    EXPECT_EQ(allocations[0].offset, 0);
+    EXPECT_EQ(allocations[1].offset, 100);
+    EXPECT_EQ(allocations[2].offset, 300);
+    EXPECT_EQ(allocations[3].id, miniram::INVALID_INDEX);
+    EXPECT_EQ(allocations[4].offset, 600);
+
+    EXPECT_GE(ram.alloc_capacity(), sizes.size());
+    EXPECT_EQ(ram.remaining(), 1024 - 1000);
+}
+
+DATA_TEST(miniram, batch_free) {
+    miniram ram(1024 * 1024);
+
+    std::vector<size_t> const sizes(64, 1024);
+    auto allocations = ram.allocate_n(sizes);
+
+    // free every other allocation in reverse order, then the rest shuffled
+    std::vector<mini_alloc> even{};
+    std::vector<mini_alloc> odd{};
+    for(size_t i = 0; i < allocations.size(); ++i)
+        (i % 2 == 0 ? even : odd).push_back(allocations[i]);
+
+    std::ranges::reverse(even);
+    ram.free_n(even);
+
+    EXPECT_EQ(ram.remaining(), ram.capacity() - 32 * 1024);
+
+    auto const regions = ram.free_regions();
+    size_t freeBlocks = 0;
+    for(auto const& region : regions)
+        freeBlocks += region.count;
+    EXPECT_EQ(freeBlocks, 33);
+
+    std::mt19937 gen(42);
+    std::ranges::shuffle(odd, gen);
+    ram.free_n(odd);
+
+    EXPECT_TRUE(ram.empty());
+    EXPECT_EQ(ram.max_alloc(), ram.capacity());
+
+    auto const all = ram.allocate(ram.capacity());
+    EXPECT_EQ(all.offset, 0);
+}
+
+DATA_TEST(miniram, batch_free_matches_single_free) {
+    miniram batched(64 * 1024);
+    miniram single(64 * 1024);
+
+    std::vector<size_t> sizes{};
+    for(size_t i = 1; i <= 48; ++i)
+        sizes.push_back(i * 17);
+
+    auto const batchedAllocs = batched.allocate_n(sizes);
+    std::vector<mini_alloc> singleAllocs{};
+    for(auto const size : sizes)
+        singleAllocs.push_back(single.allocate(size));
+
+    std::vector<mini_alloc> batchedFrees{};
+    for(size_t i = 0; i < sizes.size(); ++i) {
+        if(i % 3 == 2)
+            continue;
+        batchedFrees.push_back(batchedAllocs[i]);
+        single.free(singleAllocs[i]);
+    }
+    batched.free_n(batchedFrees);
+
+    EXPECT_EQ(batched.remaining(), single.remaining());
+    EXPECT_EQ(batched.max_alloc(), single.max_alloc());
+
+    auto const batchedRegions = batched.free_regions();
+    auto const singleRegions = single.free_regions();
+    for(size_t i = 0; i < batchedRegions.size(); ++i)
+        EXPECT_EQ(batchedRegions[i].count, singleRegions[i].count);
+}
+
+DATA_TEST(miniram, aligned_allocation) {
+    miniram allocator(1024 * 1024);
+
+    auto const a = allocator.allocate(3);
+    EXPECT_EQ(a.offset, 0);
+
+    auto const b = allocator.allocate(100, 64);
+    EXPECT_EQ(b.offset, 64);
+    EXPECT_EQ(allocator.size_of(b), 100);
+
+    // padding stays allocatable
+    EXPECT_EQ(allocator.remaining(), 1024 * 1024 - 103);
+    auto const c = allocator.allocate(60);
+    EXPECT_EQ(c.offset, 3);
+
+    auto const d = allocator.allocate(1, 256);
+    EXPECT_EQ(d.offset % 256, 0);
+
+    auto const e = allocator.allocate(7, 1);
+    EXPECT_NE(e.id, miniram::INVALID_INDEX);
+
+    for(auto const& alloc : {a, b, c, d, e})
+        allocator.free(alloc);
+
+    EXPECT_TRUE(allocator.empty());
+    auto const all = allocator.allocate(1024 * 1024);
+    EXPECT_EQ(all.offset, 0);
+}
+
+DATA_TEST(miniram, aligned_allocation_packs_into_holes) {
+    miniram allocator(4096, 16);
+
+    std::vector<mini_alloc> allocs{};
+    for(size_t i = 0; i < 16; ++i)
+        allocs.push_back(allocator.allocate(256));
+
+    // free every other block, leaving 256 element holes at 256 aligned offsets
+    for(size_t i = 0; i < allocs.size(); i += 2)
+        allocator.free(allocs[i]);
+
+    for(size_t i = 0; i < allocs.size(); i += 2) {
+        auto const alloc = allocator.allocate(256, 256);
+        ASSERT_NE(alloc.id, miniram::INVALID_INDEX);
+        EXPECT_EQ(alloc.offset % 256, 0);
+    }
+
+    EXPECT_TRUE(allocator.exhausted());
+    EXPECT_EQ(allocator.allocate(1, 2).id, miniram::INVALID_INDEX);
+}
+
+DATA_TEST(miniram, best_fit_placement) {
+    using best_fit_ram = basic_miniram<size_t, uint32_t, mini_config{.placement = MiniPlacement::BEST_FIT}>;
+
+    auto const run = []<class Ram>(Ram ram) {
+        auto const a = ram.allocate(300);
+        [[maybe_unused]] auto const b = ram.allocate(20);
+        auto const c = ram.allocate(260);
+        [[maybe_unused]] auto const d = ram.allocate(20);
+
+        ram.free(a);
+        ram.free(c);
+
+        return ram.allocate(260).offset;
+    };
+
+    EXPECT_EQ(run(miniram{4096}), 0);
+    EXPECT_EQ(run(best_fit_ram{4096}), 320);
+}
+
+DATA_TEST(miniram, lowest_address_placement) {
+    using lowest_address_ram =
+        basic_miniram<size_t, uint32_t, mini_config{.placement = MiniPlacement::LOWEST_ADDRESS}>;
+
+    auto const run = []<class Ram>(Ram ram) {
+        auto const a = ram.allocate(300);
+        [[maybe_unused]] auto const b = ram.allocate(20);
+        auto const c = ram.allocate(300);
+        [[maybe_unused]] auto const d = ram.allocate(20);
+
+        ram.free(a);
+        ram.free(c);
+
+        return ram.allocate(288).offset;
+    };
+
+    EXPECT_EQ(run(miniram{4096}), 320);
+    EXPECT_EQ(run(lowest_address_ram{4096}), 0);
+}
+
+DATA_TEST(miniram, bins_per_leaf) {
+    using fine_ram = basic_miniram<size_t, uint32_t, mini_config{.binsPerLeaf = 32}>;
+    using coarse_ram = basic_miniram<uint32_t, uint32_t, mini_config{.binsPerLeaf = 4}>;
+
+    EXPECT_EQ(fine_ram{1024}.free_regions().size(), sizeof(size_t) * 8 * 32);
+    EXPECT_EQ(coarse_ram{1024}.free_regions().size(), sizeof(uint32_t) * 8 * 4);
+
+    // a 300 element hole only serves 290 elements with fine size classes
+    auto const run = []<class Ram>(Ram ram) {
+        auto const a = ram.allocate(300);
+        [[maybe_unused]] auto const b = ram.allocate(20);
+        ram.free(a);
+
+        return ram.allocate(290).offset;
+    };
+
+    EXPECT_EQ(run(miniram{4096}), 320);
+    EXPECT_EQ(run(fine_ram{4096}), 0);
+
+    coarse_ram coarse{1024 * 1024};
+    std::vector<mini_alloc32> allocs{};
+    for(uint32_t i = 1; i < 200; ++i)
+        allocs.push_back(coarse.allocate(i * 7));
+
+    for(auto const& alloc : allocs)
+        coarse.free(alloc);
+
+    EXPECT_EQ(coarse.allocate(1024 * 1024).offset, 0);
+}
+
+DATA_TEST(miniram, leaf_masks_wider_than_size_type) {
+    // 64 bins per leaf need 64 bit leaf masks, the size type only has 32 bits
+    using wide_leaf_ram = basic_miniram<uint32_t, uint32_t, mini_config{.binsPerLeaf = 64}>;
+
+    wide_leaf_ram ram{63};
+    EXPECT_EQ(ram.max_alloc(), 63);
+    EXPECT_FLOAT_EQ(ram.fragmentation(), 0.0f);
+
+    wide_leaf_ram big{100'000};
+    auto const a = big.allocate(1000);
+    [[maybe_unused]] auto const b = big.allocate(10);
+    big.free(a);
+
+    EXPECT_LE(big.max_alloc(), big.remaining());
+    EXPECT_NE(big.allocate(big.max_alloc()).offset, wide_leaf_ram::NO_SPACE);
+}
+
+DATA_TEST(miniram, stats) {
+    static_assert(sizeof(miniram) == sizeof(basic_miniram<size_t, uint32_t, mini_config{}>));
+
+    miniram_stats ram{1024};
+
+    auto const a = ram.allocate(100);
+    auto const b = ram.allocate(200, 64);
+    [[maybe_unused]] auto const c = ram.allocate(300);
+    EXPECT_EQ(ram.allocate(1024).id, miniram_stats::INVALID_INDEX);
+
+    ram.free(a);
+    ram.free_n(std::array{b});
+    [[maybe_unused]] auto const report = ram.defragment();
+    [[maybe_unused]] auto const step = ram.defragment_step(1024);
+
+    auto const stats = ram.stats();
+    EXPECT_EQ(stats.allocs, 3);
+    EXPECT_EQ(stats.frees, 2);
+    EXPECT_EQ(stats.failedAllocs, 1);
+    EXPECT_EQ(stats.peakAllocated, 600);
+    EXPECT_EQ(stats.defragmentations, 2);
+    // every allocation is cut from the single big block
+    EXPECT_EQ(stats.binMisses, 3);
+
+    uint64_t classAllocs = 0;
+    uint64_t requested = 0;
+    for(auto const& sizeClass : stats.sizeClasses) {
+        classAllocs += sizeClass.allocs;
+        requested += sizeClass.requested;
+        EXPECT_GE(sizeClass.granted, sizeClass.requested);
+    }
+    EXPECT_EQ(classAllocs, 3);
+    EXPECT_EQ(requested, 600);
+
+    ram.reset_stats();
+    EXPECT_EQ(ram.stats().allocs, 0);
+    EXPECT_EQ(ram.stats().peakAllocated, ram.allocated());
+}
+
 DATA_TEST(miniram, query_methods) {
     miniram allocator(1024);
 
@@ -300,6 +561,170 @@ DATA_TEST(miniheap, post_defrag_integrity) {
     EXPECT_EQ(offset, 0);
 }
 
+DATA_TEST(miniram, incremental_defragmentation) {
+    constexpr size_t capacity = 64 * 1024;
+    constexpr size_t budget = 1024;
+
+    miniram ram(capacity);
+    std::vector<uint32_t> memory(capacity, 0);
+    std::map<miniram::index_type, mini_alloc> liveAllocs;
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<size_t> sizeDist(1, 512);
+
+    for(uint32_t tag = 1; tag <= 200; ++tag) {
+        auto const alloc = ram.allocate(sizeDist(gen));
+        ASSERT_NE(alloc.id, miniram::INVALID_INDEX);
+
+        std::fill_n(memory.begin() + alloc.offset, ram.size_of(alloc), tag);
+        liveAllocs[alloc.id] = alloc;
+    }
+
+    std::map<miniram::index_type, uint32_t> tags;
+    for(auto const& [id, alloc] : liveAllocs)
+        tags[id] = memory[alloc.offset];
+
+    size_t freed = 0;
+    for(auto it = liveAllocs.begin(); it != liveAllocs.end(); ++freed) {
+        if(freed % 3 != 0) {
+            ++it;
+            continue;
+        }
+        ram.free(it->second);
+        tags.erase(it->first);
+        it = liveAllocs.erase(it);
+    }
+
+    size_t steps = 0;
+    while(true) {
+        auto const [report, moved, complete] = ram.defragment_step(budget);
+        ++steps;
+
+        EXPECT_TRUE(moved <= budget || report.updatedAllocs.size() == 1);
+
+        for(auto const& move : report.moves)
+            std::memmove(&memory[move.dstOffset], &memory[move.srcOffset], move.size * sizeof(uint32_t));
+        for(auto const& updated : report.updatedAllocs)
+            liveAllocs[updated.id].offset = updated.offset;
+
+        if(complete)
+            break;
+    }
+    EXPECT_GT(steps, 1);
+
+    size_t liveSize = 0;
+    for(auto const& [id, alloc] : liveAllocs) {
+        auto const size = ram.size_of(alloc);
+        liveSize += size;
+
+        for(size_t i = 0; i < size; ++i)
+            ASSERT_EQ(memory[alloc.offset + i], tags[id]);
+    }
+
+    EXPECT_EQ(ram.remaining(), capacity - liveSize);
+
+    auto fullyDefragmented = ram;
+    EXPECT_TRUE(fullyDefragmented.defragment().moves.empty());
+    EXPECT_EQ(ram.max_alloc(), fullyDefragmented.max_alloc());
+
+    auto const rest = ram.allocate(ram.max_alloc());
+    EXPECT_EQ(rest.offset, liveSize);
+
+    // compacted ram needs no further moves
+    ram.free(rest);
+    auto const final = ram.defragment_step(budget);
+    EXPECT_TRUE(final.complete);
+    EXPECT_TRUE(final.report.moves.empty());
+}
+
+DATA_TEST(miniram, incremental_defragmentation_restarts_on_free) {
+    miniram ram(4096);
+
+    std::vector<mini_alloc> allocations;
+    for(int i = 0; i < 8; ++i)
+        allocations.push_back(ram.allocate(256));
+
+    ram.free(allocations[0]);
+    ram.free(allocations[2]);
+
+    auto const first = ram.defragment_step(1);
+    EXPECT_FALSE(first.complete);
+    ASSERT_EQ(first.report.updatedAllocs.size(), 1);
+    EXPECT_EQ(first.report.updatedAllocs[0].id, allocations[1].id);
+    EXPECT_EQ(first.report.updatedAllocs[0].offset, 0);
+
+    // the cursor allocation is freed -> next step restarts the pass
+    ram.free(allocations[3]);
+
+    size_t steps = 0;
+    while(!ram.defragment_step(1).complete)
+        ++steps;
+
+    EXPECT_EQ(steps, 3);
+
+    auto const rest = ram.allocate(ram.max_alloc());
+    EXPECT_EQ(rest.offset, 5 * 256);
+}
+
+DATA_TEST(miniram, soa_layout_matches_aos) {
+    constexpr uint32_t capacity = 1024 * 1024;
+
+    miniram aos{capacity, 4};
+    miniram_soa soa{capacity, 4};
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<uint32_t> sizeDist{1, 512};
+    std::uniform_int_distribution<> opDist{0, 99};
+
+    std::vector<mini_alloc> aosLive{};
+    std::vector<mini_alloc> soaLive{};
+
+    for(size_t i = 0; i < 5000; ++i) {
+        if(opDist(gen) < 60 || aosLive.empty()) {
+            auto const size = sizeDist(gen);
+            auto const a = aos.allocate(size);
+            auto const b = soa.allocate(size);
+
+            ASSERT_EQ(a.offset, b.offset);
+            ASSERT_EQ(a.id, b.id);
+            if(a.id != miniram::INVALID_INDEX) {
+                aosLive.push_back(a);
+                soaLive.push_back(b);
+            }
+            continue;
+        }
+
+        auto const index = std::uniform_int_distribution<size_t>{0, aosLive.size() - 1}(gen);
+        aos.free(aosLive[index]);
+        soa.free(soaLive[index]);
+
+        std::swap(aosLive[index], aosLive.back());
+        std::swap(soaLive[index], soaLive.back());
+        aosLive.pop_back();
+        soaLive.pop_back();
+    }
+
+    EXPECT_EQ(aos.remaining(), soa.remaining());
+    EXPECT_EQ(aos.max_alloc(), soa.max_alloc());
+
+    auto copy = soa;
+
+    auto const aosReport = aos.defragment();
+    auto const soaReport = soa.defragment();
+
+    ASSERT_EQ(aosReport.updatedAllocs.size(), soaReport.updatedAllocs.size());
+    for(size_t i = 0; i < aosReport.updatedAllocs.size(); ++i) {
+        EXPECT_EQ(aosReport.updatedAllocs[i].offset, soaReport.updatedAllocs[i].offset);
+        EXPECT_EQ(aosReport.updatedAllocs[i].id, soaReport.updatedAllocs[i].id);
+    }
+    EXPECT_EQ(aos.max_alloc(), soa.max_alloc());
+
+    // copies are independent
+    EXPECT_EQ(copy.defragment().updatedAllocs.size(), soaReport.updatedAllocs.size());
+    for(auto const& alloc : soaReport.updatedAllocs)
+        EXPECT_GT(soa.size_of(alloc), 0);
+}
+
 DATA_TEST(miniram, resize_operations) {
     miniram ram(1024);
 
@@ -325,4 +750,312 @@ DATA_TEST(miniram, resize_operations) {
     EXPECT_EQ(ram2.capacity(), 1024);
     EXPECT_EQ(ram2.remaining(), 1024 - 300);
 }
+
+DATA_TEST(miniram, resize_in_place) {
+    miniram ram(1024);
+
+    auto const a = ram.allocate(512);
+    auto const b = ram.allocate(512);
+
+    // appends behind the used tail
+    EXPECT_TRUE(ram.resize_in_place(2048));
+    EXPECT_EQ(ram.capacity(), 2048);
+    EXPECT_EQ(ram.remaining(), 1024);
+    auto const c = ram.allocate(1000);
+    EXPECT_EQ(c.offset, 1024);
+
+    // extends the free tail
+    EXPECT_TRUE(ram.resize_in_place(4096));
+    EXPECT_EQ(ram.remaining(), 2072);
+    auto const d = ram.allocate(2048);
+    EXPECT_EQ(d.offset, 2024);
+
+    ram.free(c);
+    ram.free(d);
+
+    // the cut off range must be free
+    EXPECT_FALSE(ram.resize_in_place(512));
+    EXPECT_EQ(ram.capacity(), 4096);
+
+    EXPECT_TRUE(ram.resize_in_place(1024));
+    EXPECT_EQ(ram.capacity(), 1024);
+    EXPECT_EQ(ram.remaining(), 0);
+    EXPECT_EQ(ram.size_of(b), 512);
+
+    ram.free(a);
+    ram.free(b);
+    EXPECT_TRUE(ram.resize_in_place(0));
+    EXPECT_TRUE(ram.resize_in_place(512));
+    EXPECT_EQ(ram.allocate(512).offset, 0);
+}
+
+DATA_TEST(miniram, snapshot_restore) {
+    auto const run = []<class Ram>() {
+        Ram ram{64 * 1024, 4};
+
+        std::mt19937 gen{7};
+        std::uniform_int_distribution<uint32_t> sizeDist{1, 700};
+
+        std::vector<mini_alloc> live{};
+        for(size_t i = 0; i < 2000; ++i) {
+            if(gen() % 3 != 0 || live.empty()) {
+                auto const alloc = ram.allocate(sizeDist(gen));
+                if(alloc.id != Ram::INVALID_INDEX)
+                    live.push_back(alloc);
+                continue;
+            }
+
+            auto const index = gen() % live.size();
+            ram.free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+
+        auto const blob = ram.snapshot();
+        EXPECT_EQ(blob.size(), ram.snapshot_size());
+
+        auto restored = Ram::restore(blob);
+        EXPECT_EQ(restored.capacity(), ram.capacity());
+        EXPECT_EQ(restored.remaining(), ram.remaining());
+        EXPECT_EQ(restored.max_alloc(), ram.max_alloc());
+        EXPECT_EQ(restored.snapshot(), blob);
+
+        for(auto const& alloc : live)
+            EXPECT_EQ(restored.size_of(alloc), ram.size_of(alloc));
+
+        // both continue identically
+        size_t continued = 0;
+        for(size_t i = 0; i < 100; ++i) {
+            auto const size = sizeDist(gen);
+            auto const a = ram.allocate(size);
+            auto const b = restored.allocate(size);
+            EXPECT_EQ(a.offset, b.offset);
+            EXPECT_EQ(a.id, b.id);
+            continued += a.id != Ram::INVALID_INDEX;
+        }
+
+        restored.free_n(live);
+        auto const report = restored.defragment();
+        EXPECT_EQ(report.updatedAllocs.size(), continued);
+    };
+
+    run.template operator()<miniram>();
+    run.template operator()<miniram_soa>();
+    run.template operator()<basic_miniram<size_t, uint32_t, mini_config{.generationBits = 8}>>();
+
+    auto blob = miniram{1024}.snapshot();
+    EXPECT_ANY_THROW(static_cast<void>(miniram_soa::restore(blob)));
+    EXPECT_ANY_THROW(static_cast<void>(miniram::restore(std::span{blob}.first(blob.size() - 1))));
+}
+
+DATA_TEST(miniram, clear_rebuilds_free_node_stack) {
+    miniram ram{1024 * 1024, 4};
+
+    std::mt19937 gen{5};
+    std::vector<mini_alloc> live{};
+
+    // scrambles the free node stack and grows it past the initial node count
+    for(size_t i = 0; i < 500; ++i) {
+        if(gen() % 3 != 0 || live.empty()) {
+            live.push_back(ram.allocate(gen() % 64 + 1));
+            continue;
+        }
+
+        auto const index = gen() % live.size();
+        ram.free(live[index]);
+        live[index] = live.back();
+        live.pop_back();
+    }
+
+    auto const nodeCount = ram.alloc_capacity() + 1;
+    ram.clear();
+
+    std::set<miniram::index_type> ids{};
+    std::vector<mini_alloc> allocs{};
+    for(size_t i = 0; i < nodeCount + 16; ++i) {
+        auto const alloc = ram.allocate(16);
+        ASSERT_NE(alloc.id, miniram::INVALID_INDEX);
+
+        EXPECT_TRUE(ids.insert(alloc.id).second);
+        allocs.push_back(alloc);
+    }
+
+    std::ranges::sort(allocs, {}, &mini_alloc::offset);
+    for(size_t i = 1; i < allocs.size(); ++i)
+        EXPECT_GE(allocs[i].offset, allocs[i - 1].offset + 16);
+}
+
+DATA_TEST(miniram, restore_rejects_corruption) {
+    miniram ram{64 * 1024, 4};
+    std::vector<mini_alloc> live{};
+    for(uint32_t i = 1; i < 200; ++i)
+        live.push_back(ram.allocate(i * 3));
+    for(size_t i = 0; i < live.size(); i += 2)
+        ram.free(live[i]);
+
+    auto const blob = ram.snapshot();
+
+    // [format:7 * 4][capacity][free storage][nodes][free stack ptr][head][tail][defrag cursor]
+    constexpr size_t stateOffset = 7 * sizeof(uint32_t);
+    auto const corrupt = [&blob](size_t offset, uint64_t value) {
+        auto copy = blob;
+        std::memcpy(copy.data() + offset, &value, sizeof(value));
+        return copy;
+    };
+
+    auto const nodeCount = ram.alloc_capacity() + 1;
+    EXPECT_ANY_THROW(static_cast<void>(miniram::restore(corrupt(stateOffset + 2 * 8, ~uint64_t{0}))));
+    EXPECT_ANY_THROW(static_cast<void>(miniram::restore(corrupt(stateOffset + 3 * 8, nodeCount + 1))));
+    EXPECT_ANY_THROW(static_cast<void>(miniram::restore(corrupt(stateOffset + 4 * 8, nodeCount + 1))));
+    EXPECT_ANY_THROW(static_cast<void>(miniram::restore(corrupt(stateOffset + 1 * 8, 128 * 1024))));
+
+    // nodes sit in front of the free stack at the end of the blob
+    using node_type = dev::basic_mini_node<size_t, uint32_t>;
+    auto const nodesOffset = blob.size() - nodeCount * (sizeof(node_type) + sizeof(uint32_t));
+    auto const nodeField = [&](size_t node, size_t field) {
+        return nodesOffset + node * sizeof(node_type) + field;
+    };
+
+    auto const head = [&] {
+        uint64_t value = 0;
+        std::memcpy(&value, blob.data() + stateOffset + 4 * 8, sizeof(value));
+        return static_cast<size_t>(value);
+    }();
+
+    // neighbor chain cycle
+    auto cycle = blob;
+    auto const self = static_cast<uint32_t>(head);
+    std::memcpy(cycle.data() + nodeField(head, offsetof(node_type, neighborNext)), &self, sizeof(self));
+    EXPECT_ANY_THROW(static_cast<void>(miniram::restore(cycle)));
+
+    // used flag that isn't a bool
+    auto flag = blob;
+    flag[nodeField(head, offsetof(node_type, used))] = std::byte{2};
+    EXPECT_ANY_THROW(static_cast<void>(miniram::restore(flag)));
+
+    // a used node claims to be free, it isn't in any bin
+    auto unused = blob;
+    for(size_t i = 0; i < nodeCount; ++i)
+        if(unused[nodeField(i, offsetof(node_type, used))] == std::byte{1}) {
+            unused[nodeField(i, offsetof(node_type, used))] = std::byte{0};
+            break;
+        }
+    EXPECT_ANY_THROW(static_cast<void>(miniram::restore(unused)));
+
+    // random byte flips restore a consistent state or throw, reading them is never UB
+    std::mt19937 gen{11};
+    for(size_t i = 0; i < 2000; ++i) {
+        auto copy = blob;
+        copy[gen() % copy.size()] ^= static_cast<std::byte>(1u << gen() % 8);
+
+        try {
+            static_cast<void>(miniram::restore(copy));
+        } catch(...) {}
+    }
+}
+
+DATA_TEST(miniram, snapshot_after_shrink) {
+    {
+        // freed nodes keep ranges past the shrunk capacity
+        miniram32 ram(1024, 8);
+        auto const a = ram.allocate(100);
+        auto const b = ram.allocate(700);
+        ram.free(a);
+        static_cast<void>(ram.resize(800));
+
+        auto const restored = miniram32::restore(ram.snapshot());
+        EXPECT_EQ(restored.capacity(), 800);
+        EXPECT_EQ(restored.size_of(b), 700);
+    }
+
+    auto const run = []<class Ram>() {
+        Ram ram{16 * 1024, 4};
+
+        std::mt19937 gen{13};
+        std::vector<mini_alloc> live{};
+
+        for(size_t i = 0; i < 3000; ++i) {
+            switch(gen() % 8) {
+                case 0: {
+                    auto const slack = gen() % 4096;
+                    static_cast<void>(ram.resize(ram.allocated() + slack));
+                    break;
+                }
+                case 1: {
+                    auto const cut = std::min<typename Ram::size_type>(ram.capacity(), gen() % 2048);
+                    ram.resize_in_place(ram.capacity() - cut);
+                    break;
+                }
+                case 2: ram.resize_in_place(ram.capacity() + gen() % 2048); break;
+                case 3: static_cast<void>(ram.defragment_step(gen() % 512)); break;
+                case 4:
+                    if(!live.empty()) {
+                        auto const index = gen() % live.size();
+                        ram.free(live[index]);
+                        live[index] = live.back();
+                        live.pop_back();
+                    }
+                    break;
+                default: {
+                    auto const alloc = ram.allocate(gen() % 300 + 1);
+                    if(alloc.id != Ram::INVALID_INDEX)
+                        live.push_back(alloc);
+                }
+            }
+
+            if(i % 10 != 0)
+                continue;
+
+            auto const blob = ram.snapshot();
+            auto const restored = Ram::restore(blob);
+            ASSERT_EQ(restored.snapshot(), blob);
+        }
+    };
+
+    run.template operator()<miniram>();
+    run.template operator()<miniram_soa>();
+}
+
+DATA_TEST(miniram, generation_handles) {
+    using checked_miniram = basic_miniram<size_t, uint32_t, mini_config{.generationBits = 8}>;
+    checked_miniram ram(1024, 16);
+
+    auto const a = ram.allocate(64);
+    EXPECT_TRUE(ram.valid(a));
+    EXPECT_EQ(ram.size_of(a), 64);
+
+    ram.free(a);
+    EXPECT_FALSE(ram.valid(a));
+
+    // same node, next generation
+    auto const b = ram.allocate(64);
+    EXPECT_EQ(b.offset, a.offset);
+    EXPECT_TRUE(ram.valid(b));
+
+    if constexpr(debug_mode()) {
+        EXPECT_NE(b.id, a.id);
+        EXPECT_FALSE(ram.valid(a));
+    }
+
+    // handles survive moves
+    auto const c = ram.allocate(32);
+    ram.free(b);
+
+    auto const report = ram.defragment();
+    ASSERT_EQ(report.updatedAllocs.size(), 1);
+    EXPECT_EQ(report.updatedAllocs[0].id, c.id);
+    EXPECT_TRUE(ram.valid(report.updatedAllocs[0]));
+    EXPECT_EQ(ram.size_of(report.updatedAllocs[0]), 32);
+
+    // generations wrap without producing INVALID_INDEX
+    for(size_t i = 0; i < 1000; ++i) {
+        auto const alloc = ram.allocate(16);
+        ASSERT_NE(alloc.id, checked_miniram::INVALID_INDEX);
+        ram.free(alloc);
+    }
+
+    ram.clear();
+    EXPECT_FALSE(ram.valid(c));
+    EXPECT_TRUE(ram.defragment().updatedAllocs.empty());
+}
 }
@@ -0,0 +1,47 @@
+#include "cth/data/mirrored_buffer.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+
+namespace cth::dt {
+
+DATA_TEST(mirrored_buffer, views_alias) {
+    auto const unit = mirrored_buffer::granularity();
+
+    mirrored_buffer buffer{unit + 1};
+    EXPECT_EQ(buffer.size(), 2 * unit);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data()) % unit, 0);
+
+    auto* const data = buffer.data();
+    auto const size = buffer.size();
+
+    // a write across the end lands at the start
+    std::ranges::fill_n(data + size - 8, 16, std::byte{42});
+    EXPECT_EQ(data[size - 1], std::byte{42});
+    EXPECT_EQ(data[0], std::byte{42});
+    EXPECT_EQ(data[7], std::byte{42});
+    EXPECT_EQ(data[8], std::byte{0});
+
+    data[100] = std::byte{7};
+    EXPECT_EQ(data[size + 100], std::byte{7});
+}
+
+DATA_TEST(mirrored_buffer, move) {
+    mirrored_buffer a{1};
+    auto* const data = a.data();
+
+    mirrored_buffer b{std::move(a)};
+    EXPECT_EQ(a.data(), nullptr);
+    EXPECT_EQ(a.size(), 0);
+    EXPECT_EQ(b.data(), data);
+    EXPECT_EQ(b.size(), mirrored_buffer::granularity());
+
+    mirrored_buffer c{};
+    c = std::move(b);
+    EXPECT_EQ(c.data(), data);
+    EXPECT_EQ(b.data(), nullptr);
+}
+
+}
@@ -2,6 +2,7 @@
 #include "test.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -221,4 +222,140 @@ DATA_TEST(pool, move_only_types) {
     EXPECT_EQ(p.remaining(), 1);
 }
 
+DATA_TEST(pool, many_release_reacquire) {
+    pool<int> p;
+    for(int i = 0; i < 10'000; ++i)
+        p.emplace(i);
+
+    std::vector<int*> acquired{};
+    while(!p.exhausted())
+        acquired.push_back(&p.acquire());
+
+    EXPECT_EQ(acquired.size(), p.capacity());
+
+    // release in scrambled order, LIFO re-acquire
+    for(size_t i = 0; i < acquired.size(); i += 2)
+        p.release(*acquired[i]);
+    EXPECT_EQ(p.remaining(), 5'000);
+
+    EXPECT_EQ(&p.acquire(), acquired[acquired.size() - 2]);
+
+    p.clear();
+    EXPECT_EQ(p.remaining(), p.capacity());
+}
+
+DATA_TEST(pool, validating_owns) {
+    pool<int, basic_pool_manipulator, true> p;
+    p.emplace(1);
+
+    int foreign = 1;
+    EXPECT_TRUE(p.owns(p.acquire()));
+    EXPECT_FALSE(p.owns(foreign));
+}
+
+DATA_TEST(pool, chunked_storage) {
+    pool<int> p{4};
+    EXPECT_EQ(p.chunk_size(), 4);
+
+    for(int i = 0; i < 10; ++i)
+        p.emplace(i);
+    EXPECT_EQ(p.capacity(), 10);
+
+    std::vector<int*> acquired{};
+    while(!p.exhausted())
+        acquired.push_back(&p.acquire());
+
+    // LIFO, the last emplaced instance comes first
+    std::ranges::reverse(acquired);
+
+    for(size_t i = 0; i < acquired.size(); ++i) {
+        EXPECT_EQ(*acquired[i], static_cast<int>(i));
+        EXPECT_TRUE(p.owns(*acquired[i]));
+    }
+
+    // chunks start on cache lines, instances of a chunk are contiguous
+    for(size_t chunk = 0; chunk < acquired.size(); chunk += p.chunk_size()) {
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(acquired[chunk]) % CACHE_LINE_SIZE, 0);
+
+        auto const end = std::min(chunk + p.chunk_size(), acquired.size());
+        for(size_t i = chunk + 1; i < end; ++i)
+            EXPECT_EQ(
+                reinterpret_cast<std::byte*>(acquired[i]) - reinterpret_cast<std::byte*>(acquired[i - 1]),
+                reinterpret_cast<std::byte*>(acquired[1]) - reinterpret_cast<std::byte*>(acquired[0])
+            );
+    }
+}
+
+DATA_TEST(pool, lease_releases_on_destruction) {
+    pool<ResettableObject, ObjectResetter> p;
+    p.emplace(42);
+
+    {
+        auto leased = p.acquire_lease();
+        ASSERT_TRUE(leased);
+        EXPECT_EQ(leased->value, 42);
+        EXPECT_TRUE(p.exhausted());
+
+        leased->value = 99;
+    }
+
+    EXPECT_EQ(p.remaining(), 1);
+    EXPECT_EQ(p.acquire().value, 0);
+}
+
+DATA_TEST(pool, lease_move_and_reset) {
+    pool<int> p;
+    p.emplace(1);
+    p.emplace(2);
+
+    auto first = p.acquire_lease();
+    auto second = p.acquire_lease();
+    auto* const firstValue = first.get();
+
+    // assignment releases the held resource first
+    second = std::move(first);
+    EXPECT_FALSE(first);
+    EXPECT_EQ(second.get(), firstValue);
+    EXPECT_EQ(p.remaining(), 1);
+
+    lease<int> moved{std::move(second)};
+    EXPECT_EQ(p.remaining(), 1);
+
+    moved.reset();
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(p.remaining(), 2);
+}
+
+DATA_TEST(pool, move_keeps_instances) {
+    pool<int> p{2};
+    p.emplace(1);
+    p.emplace(2);
+    p.emplace(3);
+
+    auto& value = p.acquire();
+
+    pool<int> moved{std::move(p)};
+    EXPECT_EQ(p.capacity(), 0);
+    EXPECT_TRUE(p.exhausted());
+
+    EXPECT_EQ(moved.capacity(), 3);
+    EXPECT_EQ(moved.remaining(), 2);
+    EXPECT_TRUE(moved.owns(value));
+
+    moved.release(value);
+    EXPECT_EQ(&moved.acquire(), &value);
+}
+
+#ifdef _DEBUG
+DATA_TEST(pool, double_release_crash) {
+    pool<int> p;
+    p.emplace(1);
+
+    auto& value = p.acquire();
+    p.release(value);
+
+    ASSERT_DEATH(p.release(value), ".*");
+}
+#endif
+
 }
@@ -0,0 +1,114 @@
+#include "cth/data/ring_buffer.hpp"
+
+#include "test.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace cth::dt {
+
+namespace {
+bool aligned(std::span<std::byte> data) {
+    return reinterpret_cast<std::uintptr_t>(data.data()) % CACHE_LINE_SIZE == 0;
+}
+}
+
+DATA_TEST(ring_buffer, head_and_tail_on_separate_cache_lines) {
+    static_assert(alignof(ring_alloc) == CACHE_LINE_SIZE);
+    static_assert(sizeof(ring_alloc) >= 3 * CACHE_LINE_SIZE);
+    static_assert(alignof(completion_ring_alloc) == CACHE_LINE_SIZE);
+    static_assert(sizeof(completion_ring_alloc) >= 3 * CACHE_LINE_SIZE);
+}
+
+DATA_TEST(ring_buffer, spans_inside_buffer) {
+    ring_buffer buffer{256};
+
+    ASSERT_EQ(256, buffer.size());
+    ASSERT_FALSE(buffer.padded());
+    ASSERT_TRUE(aligned({buffer.data(), 1}));
+
+    auto const a = buffer.alloc(100);
+    auto const b = buffer.alloc(50);
+    ASSERT_TRUE(a.has_value() && b.has_value());
+
+    ASSERT_EQ(100, a->data.size());
+    ASSERT_EQ(50, b->data.size());
+    ASSERT_EQ(buffer.data(), a->data.data());
+    ASSERT_EQ(buffer.data() + 100, b->data.data());
+    ASSERT_EQ(150, buffer.allocated());
+
+    std::ranges::fill(a->data, std::byte{1});
+    std::ranges::fill(b->data, std::byte{2});
+    ASSERT_EQ(std::byte{1}, buffer.data()[99]);
+    ASSERT_EQ(std::byte{2}, buffer.data()[100]);
+
+    ASSERT_FALSE(buffer.alloc(200).has_value());
+
+    buffer.free(b->cleanup);
+    ASSERT_EQ(0, buffer.allocated());
+}
+
+DATA_TEST(ring_buffer, padded_allocations_stay_aligned) {
+    ring_buffer buffer{1000, {.padCacheLines = true}};
+
+    ASSERT_TRUE(buffer.padded());
+    ASSERT_EQ(1024, buffer.size());
+
+    // wraps several times, every span starts on its own cache line
+    for(size_t i = 1; i < 200; ++i) {
+        auto const a = buffer.alloc(i % 150 + 1);
+        ASSERT_TRUE(a.has_value());
+        ASSERT_TRUE(aligned(a->data));
+        ASSERT_EQ(i % 150 + 1, a->data.size());
+        ASSERT_EQ(0, buffer.allocated() % CACHE_LINE_SIZE);
+
+        buffer.free(a->cleanup);
+    }
+}
+
+DATA_TEST(ring_buffer, completion_out_of_order_free) {
+    completion_ring_buffer buffer{512, {.padCacheLines = true}, 8};
+
+    std::vector<completion_ring_buffer::allocation> allocs{};
+    for(size_t i = 0; i < 4; ++i) {
+        auto const a = buffer.alloc(100);
+        ASSERT_TRUE(a.has_value());
+        ASSERT_TRUE(aligned(a->data));
+        allocs.push_back(*a);
+    }
+    ASSERT_EQ(512, buffer.allocated());
+
+    buffer.free(allocs[2].cleanup);
+    buffer.free(allocs[1].cleanup);
+    ASSERT_EQ(512, buffer.allocated());
+
+    buffer.free(allocs[0].cleanup);
+    ASSERT_EQ(128, buffer.allocated());
+
+    buffer.free(allocs[3].cleanup);
+    ASSERT_EQ(0, buffer.allocated());
+}
+
+DATA_TEST(ring_buffer, mirrored_spans_cross_the_end) {
+    ring_buffer buffer{1, {.wrap = RingWrap::MIRRORED}};
+
+    auto const size = buffer.size();
+    ASSERT_EQ(mirrored_buffer::granularity(), size);
+
+    auto const first = buffer.alloc(size - 10);
+    ASSERT_TRUE(first.has_value());
+    buffer.free(first->cleanup);
+
+    // contiguous across the end, the tail bytes alias the buffer begin
+    auto const second = buffer.alloc(20);
+    ASSERT_TRUE(second.has_value());
+    ASSERT_EQ(buffer.data() + size - 10, second->data.data());
+    ASSERT_EQ(20, buffer.allocated());
+
+    std::ranges::fill(second->data, std::byte{3});
+    ASSERT_EQ(std::byte{3}, buffer.data()[9]);
+    ASSERT_EQ(std::byte{0}, buffer.data()[10]);
+}
+
+}
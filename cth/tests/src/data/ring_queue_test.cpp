@@ -0,0 +1,159 @@
+#include "cth/data/ring_queue.hpp"
+
+#include "test.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace cth::dt {
+
+namespace {
+struct message {
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+template<class Queue>
+bool push_message(Queue& queue, message msg, size_t extra) {
+    return queue.try_emplace(sizeof(message) + extra, [msg](std::span<std::byte> payload) {
+        std::memcpy(payload.data(), &msg, sizeof(msg));
+        auto const tail = payload.subspan(sizeof(msg));
+        std::memset(tail.data(), static_cast<int>(msg.sequence & 0xff), tail.size());
+    });
+}
+
+message read_message(std::span<std::byte const> payload) {
+    message msg{};
+    std::memcpy(&msg, payload.data(), sizeof(msg));
+    return msg;
+}
+
+bool tail_intact(std::span<std::byte const> payload, uint32_t sequence) {
+    return std::ranges::all_of(payload.subspan(sizeof(message)), [sequence](std::byte b) {
+        return b == static_cast<std::byte>(sequence & 0xff);
+    });
+}
+
+template<class Queue>
+void run_concurrent(size_t producer_count, size_t consumer_count) {
+    constexpr uint32_t COUNT = 20'000;
+
+    Queue queue{4096};
+
+    std::vector<std::atomic<uint32_t>> next(producer_count);
+    std::atomic<size_t> consumed{0};
+    std::atomic<bool> failed{false};
+
+    {
+        std::vector<std::jthread> threads{};
+        for(uint32_t p = 0; p < producer_count; ++p)
+            threads.emplace_back([&queue, p] {
+                for(uint32_t i = 0; i < COUNT; ++i)
+                    while(!push_message(queue, {p, i}, i % 57))
+                        std::this_thread::yield();
+            });
+
+        for(size_t c = 0; c < consumer_count; ++c)
+            threads.emplace_back([&] {
+                while(consumed.load() < producer_count * COUNT) {
+                    auto const read = queue.drain([&](std::span<std::byte const> payload) {
+                        auto const msg = read_message(payload);
+
+                        // drains are serialized and records are read in publication order
+                        if(next[msg.producer].exchange(msg.sequence + 1) != msg.sequence)
+                            failed = true;
+                        if(payload.size() != sizeof(message) + msg.sequence % 57)
+                            failed = true;
+                        if(!tail_intact(payload, msg.sequence))
+                            failed = true;
+                    });
+                    consumed.fetch_add(read);
+                    if(read == 0)
+                        std::this_thread::yield();
+                }
+            });
+    }
+
+    ASSERT_FALSE(failed.load());
+    ASSERT_EQ(producer_count * COUNT, consumed.load());
+    ASSERT_EQ(0, queue.allocated());
+}
+}
+
+DATA_TEST(ring_queue, push_and_drain) {
+    spsc_ring_queue queue{1};
+
+    ASSERT_EQ(mirrored_buffer::granularity(), queue.size());
+
+    std::array<std::byte, 5> const payload{
+        std::byte{1},
+        std::byte{2},
+        std::byte{3},
+        std::byte{4},
+        std::byte{5},
+    };
+    ASSERT_TRUE(queue.try_push(payload));
+    ASSERT_TRUE(queue.try_push({}));
+    ASSERT_EQ(16 + 8, queue.allocated());
+
+    std::vector<std::vector<std::byte>> read{};
+    auto const count = queue.drain([&](std::span<std::byte const> record) {
+        read.emplace_back(record.begin(), record.end());
+    });
+
+    ASSERT_EQ(2, count);
+    ASSERT_TRUE(std::ranges::equal(payload, read[0]));
+    ASSERT_TRUE(read[1].empty());
+    ASSERT_EQ(0, queue.allocated());
+    ASSERT_EQ(0, queue.drain([](auto) {}));
+}
+
+DATA_TEST(ring_queue, full_and_max_record) {
+    mpsc_ring_queue queue{1};
+
+    ASSERT_TRUE(queue.try_emplace(queue.max_record_size(), [](std::span<std::byte>) {}));
+    ASSERT_FALSE(queue.try_push({}));
+
+    ASSERT_EQ(1, queue.drain([&](std::span<std::byte const> record) {
+        ASSERT_EQ(queue.max_record_size(), record.size());
+    }));
+    ASSERT_TRUE(queue.try_push({}));
+}
+
+DATA_TEST(ring_queue, records_cross_the_end) {
+    spsc_ring_queue queue{1};
+
+    // 100 laps with sizes that don't divide the buffer, every record is contiguous
+    for(uint32_t i = 0; i < 100 * queue.size() / 200; ++i) {
+        ASSERT_TRUE(push_message(queue, {0, i}, 150 + i % 50));
+        ASSERT_EQ(1, queue.drain([i](std::span<std::byte const> payload) {
+            ASSERT_EQ(i, read_message(payload).sequence);
+            ASSERT_TRUE(tail_intact(payload, i));
+        }));
+    }
+}
+
+DATA_TEST(ring_queue, drain_limit) {
+    mpsc_ring_queue queue{1};
+
+    for(uint32_t i = 0; i < 10; ++i)
+        ASSERT_TRUE(push_message(queue, {0, i}, 0));
+
+    uint32_t expected = 0;
+    auto const check = [&](std::span<std::byte const> payload) {
+        ASSERT_EQ(expected++, read_message(payload).sequence);
+    };
+
+    ASSERT_EQ(4, queue.drain(check, 4));
+    ASSERT_EQ(6, queue.drain(check));
+    ASSERT_EQ(0, queue.allocated());
+}
+
+DATA_TEST(ring_queue, spsc_concurrent) { run_concurrent<spsc_ring_queue>(1, 1); }
+DATA_TEST(ring_queue, mpsc_concurrent) { run_concurrent<mpsc_ring_queue>(4, 1); }
+DATA_TEST(ring_queue, mpmc_concurrent) { run_concurrent<mpmc_ring_queue>(4, 3); }
+
+}
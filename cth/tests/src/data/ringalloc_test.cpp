@@ -2,11 +2,84 @@
 
 #include "test.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
 #include <thread>
 #include <vector>
 
 namespace cth::dt {
 
+namespace {
+/**
+ * owns the coroutine frame, the frame stays alive after completion
+ */
+struct task {
+    struct promise_type {
+        task get_return_object() { return task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit task(std::coroutine_handle<promise_type> handle) : handle{handle} {}
+    task(task&& other) noexcept : handle{std::exchange(other.handle, {})} {}
+    ~task() { destroy(); }
+
+    void destroy() {
+        if(handle)
+            std::exchange(handle, {}).destroy();
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+/**
+ * runs posted jobs when asked to
+ */
+struct manual_scheduler {
+    void post(std::move_only_function<void()> job) const {
+        std::scoped_lock lock{mutex};
+        jobs.push_back(std::move(job));
+    }
+
+    size_t run() const {
+        size_t count = 0;
+        while(true) {
+            std::move_only_function<void()> job{};
+            {
+                std::scoped_lock lock{mutex};
+                if(jobs.empty())
+                    return count;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+            ++count;
+        }
+    }
+
+    mutable std::mutex mutex{};
+    mutable std::deque<std::move_only_function<void()>> jobs{};
+};
+
+task await_alloc(
+    ring_alloc& alloc,
+    manual_scheduler const& scheduler,
+    size_t size,
+    std::optional<ring_allocation>& out
+) {
+    out = co_await alloc.alloc_async(size, scheduler);
+}
+}
+
 DATA_TEST(ring_alloc, size_and_capacity) {
     constexpr size_t expected = 100;
     ring_alloc alloc{expected};
@@ -66,6 +139,27 @@ DATA_TEST(ring_alloc, wrap_around_padding) {
     ASSERT_EQ(60, alloc.allocated());
 }
 
+DATA_TEST(ring_alloc, mirrored_wrap_without_padding) {
+    ring_alloc alloc{100, RingWrap::MIRRORED};
+
+    auto res1 = alloc.alloc(80);
+    ASSERT_TRUE(res1.has_value());
+    alloc.free(res1->cleanup);
+    ASSERT_EQ(100, alloc.max_alloc());
+
+    // continues at 80 into the mirror, no padding
+    auto res2 = alloc.alloc(40);
+    ASSERT_TRUE(res2.has_value());
+    ASSERT_EQ(80, res2->begin);
+    ASSERT_EQ(40, alloc.allocated());
+    ASSERT_EQ(60, alloc.max_alloc());
+
+    auto res3 = alloc.alloc(60);
+    ASSERT_TRUE(res3.has_value());
+    ASSERT_EQ(20, res3->begin);
+    ASSERT_FALSE(alloc.alloc(1).has_value());
+}
+
 DATA_TEST(ring_alloc, exact_boundary_allocation) {
     ring_alloc alloc{100};
 
@@ -172,4 +266,460 @@ DATA_TEST(ring_alloc, multi_thread_concurrent_allocations) {
     ASSERT_EQ(0, alloc.max_alloc());
 }
 
+DATA_TEST(ring_alloc, alloc_wait_blocks_until_free) {
+    ring_alloc alloc{100};
+
+    auto const a = alloc.alloc(50);
+    auto const b = alloc.alloc(50);
+    ASSERT_TRUE(a && b);
+
+    std::atomic<bool> done{false};
+    std::optional<ring_allocation> waited{};
+
+    std::thread producer{[&] {
+        waited = alloc.alloc_wait(40);
+        done.store(true);
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    EXPECT_FALSE(done.load());
+
+    alloc.free(a->cleanup);
+    producer.join();
+
+    ASSERT_TRUE(done.load());
+    ASSERT_EQ(0, waited->begin);
+}
+
+DATA_TEST(ring_alloc, alloc_wait_backpressure) {
+    constexpr size_t COUNT = 20'000;
+
+    ring_alloc alloc{64};
+
+    std::mutex mutex{};
+    std::deque<cleanup_t> inFlight{};
+
+    // the producer outruns the ring, every wait must be woken by a later free
+    std::thread producer{[&] {
+        for(size_t i = 0; i < COUNT; ++i) {
+            auto const result = alloc.alloc_wait(i % 32 + 1);
+            std::scoped_lock lock{mutex};
+            inFlight.push_back(result.cleanup);
+        }
+    }};
+
+    size_t freed = 0;
+    while(freed < COUNT) {
+        std::optional<cleanup_t> token{};
+        {
+            std::scoped_lock lock{mutex};
+            if(!inFlight.empty()) {
+                token = inFlight.front();
+                inFlight.pop_front();
+            }
+        }
+
+        if(token) {
+            alloc.free(*token);
+            ++freed;
+        } else
+            std::this_thread::yield();
+    }
+
+    producer.join();
+    ASSERT_EQ(0, alloc.allocated());
+}
+
+DATA_TEST(ring_alloc, alloc_async_resumes_in_order) {
+    ring_alloc alloc{100};
+    manual_scheduler const scheduler{};
+
+    auto const a = alloc.alloc(40);
+    auto const b = alloc.alloc(40);
+    ASSERT_TRUE(a && b);
+
+    std::optional<ring_allocation> first{};
+    std::optional<ring_allocation> second{};
+    std::optional<ring_allocation> ready{};
+
+    auto const readyTask = await_alloc(alloc, scheduler, 20, ready);
+    ASSERT_TRUE(ready.has_value());
+    ASSERT_EQ(80, ready->begin);
+
+    auto const firstTask = await_alloc(alloc, scheduler, 50, first);
+    auto const secondTask = await_alloc(alloc, scheduler, 10, second);
+    ASSERT_FALSE(first.has_value());
+    ASSERT_FALSE(second.has_value());
+
+    // the front request still doesn't fit, the one behind it waits as well
+    alloc.free(a->cleanup);
+    ASSERT_EQ(0, scheduler.run());
+
+    // served by the free, resumed by the scheduler
+    alloc.free(ready->cleanup);
+    ASSERT_FALSE(first.has_value());
+    ASSERT_FALSE(second.has_value());
+
+    ASSERT_EQ(2, scheduler.run());
+    ASSERT_TRUE(first.has_value() && second.has_value());
+    ASSERT_EQ(0, first->begin);
+    ASSERT_EQ(50, second->begin);
+}
+
+DATA_TEST(ring_alloc, alloc_async_destroyed_while_suspended) {
+    ring_alloc alloc{100};
+    manual_scheduler const scheduler{};
+
+    auto const a = alloc.alloc(90);
+    ASSERT_TRUE(a.has_value());
+
+    std::optional<ring_allocation> first{};
+    std::optional<ring_allocation> dropped{};
+    std::optional<ring_allocation> last{};
+
+    auto const firstTask = await_alloc(alloc, scheduler, 20, first);
+    auto droppedTask = await_alloc(alloc, scheduler, 30, dropped);
+    auto const lastTask = await_alloc(alloc, scheduler, 40, last);
+
+    // unlinks itself from the middle of the queue
+    droppedTask.destroy();
+
+    alloc.free(a->cleanup);
+    ASSERT_EQ(2, scheduler.run());
+    ASSERT_FALSE(dropped.has_value());
+    ASSERT_TRUE(first.has_value() && last.has_value());
+    ASSERT_EQ(0, first->begin);
+    ASSERT_EQ(20, last->begin);
+}
+
+DATA_TEST(ring_alloc, reservation_sub_allocates) {
+    ring_alloc alloc{100};
+    ring_alloc::reservation reservation{alloc, 40};
+
+    auto const a = reservation.alloc(10);
+    auto const b = reservation.alloc(20);
+    ASSERT_TRUE(a && b);
+    ASSERT_EQ(0, a->begin);
+    ASSERT_EQ(10, b->begin);
+    ASSERT_EQ(40, alloc.allocated());
+    ASSERT_EQ(10, reservation.reserved());
+
+    // doesn't fit the rest, the rest is handed back and a new chunk starts right after b
+    auto const c = reservation.alloc(15);
+    ASSERT_TRUE(c.has_value());
+    ASSERT_EQ(30, c->begin);
+    ASSERT_EQ(70, alloc.allocated());
+
+    reservation.flush();
+    ASSERT_EQ(45, alloc.allocated());
+    ASSERT_EQ(0, reservation.reserved());
+
+    alloc.free(a->cleanup);
+    ASSERT_EQ(35, alloc.allocated());
+    alloc.free(c->cleanup);
+    ASSERT_EQ(0, alloc.allocated());
+}
+
+DATA_TEST(ring_alloc, reservation_rest_stays_as_padding) {
+    ring_alloc alloc{100};
+
+    std::optional<ring_allocation> a{};
+    {
+        ring_alloc::reservation reservation{alloc, 40};
+        a = reservation.alloc(10);
+        ASSERT_TRUE(a.has_value());
+
+        auto const other = alloc.alloc(10);
+        ASSERT_TRUE(other.has_value());
+        ASSERT_EQ(40, other->begin);
+
+        // flushed on destruction, something was allocated behind the chunk
+    }
+    ASSERT_EQ(50, alloc.allocated());
+
+    // a small request still fits when a full chunk doesn't
+    ring_alloc::reservation reservation{alloc, 60};
+    auto const b = reservation.alloc(30);
+    ASSERT_TRUE(b.has_value());
+    ASSERT_EQ(50, b->begin);
+
+    // freeing past the padding frees it as well
+    alloc.free(b->cleanup);
+    ASSERT_EQ(0, alloc.allocated());
+}
+
+DATA_TEST(ring_alloc, reservation_concurrent) {
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr size_t ALLOCS_PER_THREAD = 1000;
+    constexpr size_t ALLOC_SIZE = 10;
+
+    ring_alloc alloc{THREAD_COUNT * ALLOCS_PER_THREAD * ALLOC_SIZE};
+
+    std::mutex mutex{};
+    std::vector<ring_allocation> allocations{};
+
+    {
+        std::vector<std::jthread> threads{};
+        for(size_t i = 0; i < THREAD_COUNT; ++i)
+            threads.emplace_back([&] {
+                ring_alloc::reservation reservation{alloc, 100};
+
+                std::vector<ring_allocation> local{};
+                for(size_t j = 0; j < ALLOCS_PER_THREAD; ++j)
+                    if(auto const result = reservation.alloc(ALLOC_SIZE))
+                        local.push_back(*result);
+
+                std::scoped_lock lock{mutex};
+                allocations.insert(allocations.end(), local.begin(), local.end());
+            });
+    }
+
+    // every allocation succeeded and none overlap
+    ASSERT_EQ(THREAD_COUNT * ALLOCS_PER_THREAD, allocations.size());
+
+    std::ranges::sort(allocations, {}, &ring_allocation::begin);
+    for(size_t i = 0; i < allocations.size(); ++i)
+        ASSERT_EQ(i * ALLOC_SIZE, allocations[i].begin);
+}
+
+DATA_TEST(ring_alloc, reservation_concurrent_free) {
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr size_t ROUNDS = 200;
+    constexpr size_t ALLOCS_PER_ROUND = 20;
+    constexpr size_t ALLOC_SIZE = 10;
+    constexpr size_t CHUNK_SIZE = 64;
+
+    // small enough to wrap many times
+    ring_alloc alloc{THREAD_COUNT * (ALLOCS_PER_ROUND * ALLOC_SIZE + 2 * CHUNK_SIZE) * 2};
+    std::vector<size_t> memory(alloc.size());
+
+    struct record {
+        ring_allocation allocation;
+        size_t owner;
+    };
+
+    std::mutex mutex{};
+    std::vector<record> records{};
+    std::atomic<bool> failed{false};
+
+    // every producer flushed, the round is checked and freed in one go
+    std::barrier sync{THREAD_COUNT, [&]() noexcept {
+        for(auto const& r : records)
+            for(size_t i = 0; i < ALLOC_SIZE; ++i)
+                if(memory[r.allocation.begin + i] != r.owner)
+                    failed = true;
+
+        auto const last = std::ranges::max(records, {}, [](record const& r) {
+            return static_cast<size_t>(r.allocation.cleanup);
+        });
+        alloc.free(last.allocation.cleanup);
+        records.clear();
+    }};
+
+    {
+        std::vector<std::jthread> threads{};
+        for(size_t t = 0; t < THREAD_COUNT; ++t)
+            threads.emplace_back([&, t] {
+                ring_alloc::reservation reservation{alloc, CHUNK_SIZE};
+
+                for(size_t round = 0; round < ROUNDS; ++round) {
+                    std::vector<record> local{};
+                    for(size_t j = 0; j < ALLOCS_PER_ROUND; ++j) {
+                        auto const result = reservation.alloc(ALLOC_SIZE);
+                        if(!result) {
+                            failed = true;
+                            break;
+                        }
+
+                        std::fill_n(memory.begin() + static_cast<ptrdiff_t>(result->begin), ALLOC_SIZE, t);
+                        local.push_back({*result, t});
+                    }
+                    reservation.flush();
+
+                    {
+                        std::scoped_lock lock{mutex};
+                        records.insert(records.end(), local.begin(), local.end());
+                    }
+                    sync.arrive_and_wait();
+                }
+            });
+    }
+
+    ASSERT_FALSE(failed);
+    ASSERT_EQ(0, alloc.allocated());
+}
+
+#ifdef _DEBUG
+DATA_TEST(ring_alloc, reservation_passed_by_free_crash) {
+    ring_alloc alloc{100};
+    ring_alloc::reservation first{alloc, 40};
+    ring_alloc::reservation second{alloc, 40};
+
+    ASSERT_TRUE(first.alloc(10).has_value());
+    auto const later = second.alloc(10);
+    ASSERT_TRUE(later.has_value());
+
+    // frees the unused rest of the first chunk as well
+    alloc.free(later->cleanup);
+    ASSERT_DEATH(static_cast<void>(first.alloc(10)), ".*");
+}
+#endif
+
+
+DATA_TEST(completion_ring_alloc, out_of_order_free) {
+    completion_ring_alloc alloc{100, 8};
+
+    auto r1 = alloc.alloc(10);
+    auto r2 = alloc.alloc(20);
+    auto r3 = alloc.alloc(30);
+    ASSERT_TRUE(r1 && r2 && r3);
+    EXPECT_EQ(10, r2->begin);
+    EXPECT_EQ(60, alloc.allocated());
+
+    // r1 is still live, the tail can't pass it
+    alloc.free(r2->cleanup);
+    EXPECT_EQ(60, alloc.allocated());
+
+    // releases r1 and the already freed r2
+    alloc.free(r1->cleanup);
+    EXPECT_EQ(30, alloc.allocated());
+
+    alloc.free(r3->cleanup);
+    EXPECT_EQ(0, alloc.allocated());
+}
+
+DATA_TEST(completion_ring_alloc, wrap_around) {
+    completion_ring_alloc alloc{100, 8};
+
+    for(size_t round = 0; round < 1000; ++round) {
+        auto const a = alloc.alloc(40);
+        auto const b = alloc.alloc(40);
+        ASSERT_TRUE(a && b);
+        ASSERT_LE(b->begin + 40, 100);
+
+        alloc.free(b->cleanup);
+        alloc.free(a->cleanup);
+        ASSERT_EQ(0, alloc.allocated());
+    }
+}
+
+DATA_TEST(completion_ring_alloc, mirrored_full_capacity) {
+    completion_ring_alloc alloc{100, RingWrap::MIRRORED, 8};
+
+    // 30 does not divide 100, every lap straddles the end without losing capacity
+    for(size_t round = 0; round < 1000; ++round) {
+        auto const a = alloc.alloc(30);
+        auto const b = alloc.alloc(30);
+        auto const c = alloc.alloc(30);
+        ASSERT_TRUE(a && b && c);
+        ASSERT_EQ(90, alloc.allocated());
+        ASSERT_EQ((a->begin + 30) % 100, b->begin);
+
+        alloc.free(b->cleanup);
+        alloc.free(a->cleanup);
+        alloc.free(c->cleanup);
+        ASSERT_EQ(0, alloc.allocated());
+    }
+}
+
+DATA_TEST(completion_ring_alloc, completion_slots_limit) {
+    completion_ring_alloc alloc{100, 4};
+    EXPECT_EQ(4, alloc.max_allocations());
+
+    std::vector<ring_allocation> allocations{};
+    for(size_t i = 0; i < 4; ++i)
+        allocations.push_back(*alloc.alloc(1));
+
+    EXPECT_FALSE(alloc.alloc(1).has_value());
+    EXPECT_EQ(0, alloc.max_alloc());
+
+    // a slot is only reusable once the tail passed it
+    alloc.free(allocations[1].cleanup);
+    EXPECT_FALSE(alloc.alloc(1).has_value());
+
+    alloc.free(allocations[0].cleanup);
+    EXPECT_TRUE(alloc.alloc(1).has_value());
+}
+
+DATA_TEST(completion_ring_alloc, concurrent_out_of_order_free) {
+    constexpr size_t PRODUCERS = 4;
+    constexpr size_t CONSUMERS = 4;
+    constexpr size_t ALLOCS_PER_PRODUCER = 20000;
+    constexpr size_t RING_SIZE = 4096;
+
+    completion_ring_alloc alloc{RING_SIZE, 64};
+    std::vector<uint8_t> memory(RING_SIZE);
+
+    std::mutex queueMutex{};
+    std::vector<std::pair<ring_allocation, size_t>> queue{};
+    std::atomic<size_t> produced{0};
+    std::atomic<size_t> consumed{0};
+    std::atomic<bool> overlap{false};
+
+    {
+        std::vector<std::jthread> threads{};
+
+        for(size_t p = 0; p < PRODUCERS; ++p)
+            threads.emplace_back([&, p] {
+                std::mt19937 gen(static_cast<uint32_t>(p));
+                std::uniform_int_distribution<size_t> sizeDist(1, 128);
+
+                for(size_t i = 0; i < ALLOCS_PER_PRODUCER;) {
+                    auto const size = sizeDist(gen);
+                    auto const allocation = alloc.alloc(size);
+                    if(!allocation) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    std::fill_n(memory.begin() + static_cast<std::ptrdiff_t>(allocation->begin), size, p + 1);
+                    {
+                        std::scoped_lock lock{queueMutex};
+                        queue.emplace_back(*allocation, size);
+                    }
+                    produced.fetch_add(1, std::memory_order::relaxed);
+                    ++i;
+                }
+            });
+
+        for(size_t c = 0; c < CONSUMERS; ++c)
+            threads.emplace_back([&, c] {
+                std::mt19937 gen(static_cast<uint32_t>(100 + c));
+
+                while(consumed.load() < PRODUCERS * ALLOCS_PER_PRODUCER) {
+                    std::optional<std::pair<ring_allocation, size_t>> item{};
+                    {
+                        std::scoped_lock lock{queueMutex};
+                        if(!queue.empty()) {
+                            // random pick, frees complete out of order
+                            std::uniform_int_distribution<size_t> indexDist(0, queue.size() - 1);
+                            auto const index = indexDist(gen);
+                            item = queue[index];
+                            queue[index] = queue.back();
+                            queue.pop_back();
+                        }
+                    }
+                    if(!item) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    auto const& [allocation, size] = *item;
+                    auto const first = memory.begin() + static_cast<std::ptrdiff_t>(allocation.begin);
+                    if(!std::all_of(first, first + static_cast<std::ptrdiff_t>(size), [&](uint8_t v) {
+                           return v == *first;
+                       }))
+                        overlap = true;
+
+                    alloc.free(allocation.cleanup);
+                    consumed.fetch_add(1);
+                }
+            });
+    }
+
+    EXPECT_FALSE(overlap.load());
+    EXPECT_EQ(PRODUCERS * ALLOCS_PER_PRODUCER, produced.load());
+    EXPECT_EQ(0, alloc.allocated());
+}
+
 }
@@ -0,0 +1,140 @@
+#include "cth/data/sharded_miniram.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+
+namespace cth::dt {
+
+DATA_TEST(sharded_miniram, construction) {
+    sharded_miniram ram(1024, 4, 16);
+
+    EXPECT_EQ(ram.capacity(), 1024);
+    EXPECT_EQ(ram.shard_count(), 4);
+    EXPECT_EQ(ram.remaining(), 1024);
+    EXPECT_EQ(ram.max_alloc(), 256);
+
+    sharded_miniram tiny(2, 8, 16);
+    EXPECT_EQ(tiny.shard_count(), 2);
+}
+
+DATA_TEST(sharded_miniram, basic_operations) {
+    sharded_miniram ram(1024, 4, 16);
+
+    auto a = ram.allocate(100);
+    ASSERT_NE(a.id, sharded_miniram::INVALID_INDEX);
+    EXPECT_EQ(ram.size_of(a), 100);
+    EXPECT_EQ(ram.allocated(), 100);
+
+    ram.free(a);
+    EXPECT_EQ(ram.remaining(), 1024);
+}
+
+DATA_TEST(sharded_miniram, steals_from_other_shards) {
+    sharded_miniram ram(1024, 4, 16);
+
+    std::vector<mini_alloc> allocations;
+    for(int i = 0; i < 4; ++i) {
+        allocations.push_back(ram.allocate(256));
+        ASSERT_NE(allocations.back().id, sharded_miniram::INVALID_INDEX);
+    }
+
+    EXPECT_EQ(ram.remaining(), 0);
+    EXPECT_EQ(ram.allocate(1).id, sharded_miniram::INVALID_INDEX);
+
+    std::ranges::sort(allocations, {}, &mini_alloc::offset);
+    for(size_t i = 0; i < allocations.size(); ++i)
+        EXPECT_EQ(allocations[i].offset, i * 256);
+
+    for(auto const& alloc : allocations)
+        ram.free(alloc);
+
+    EXPECT_EQ(ram.remaining(), 1024);
+}
+
+DATA_TEST(sharded_miniram, ids_are_unique) {
+    sharded_miniram ram(4096, 4, 16);
+
+    std::vector<mini_alloc> allocations;
+    for(int i = 0; i < 16; ++i)
+        allocations.push_back(ram.allocate(256));
+
+    std::vector<uint32_t> ids;
+    for(auto const& alloc : allocations)
+        ids.push_back(alloc.id);
+
+    std::ranges::sort(ids);
+    EXPECT_EQ(std::ranges::adjacent_find(ids), ids.end());
+}
+
+DATA_TEST(sharded_miniram, defragment_report_is_global) {
+    sharded_miniram ram(1024, 2, 16);
+
+    std::vector<mini_alloc> allocations;
+    for(int i = 0; i < 8; ++i)
+        allocations.push_back(ram.allocate(128));
+
+    ram.free(allocations[0]);
+    ram.free(allocations[4]);
+
+    std::ranges::sort(allocations, {}, &mini_alloc::offset);
+
+    auto const report = ram.defragment();
+
+    EXPECT_EQ(report.updatedAllocs.size(), 6);
+    EXPECT_EQ(report.moves.size(), 2);
+
+    for(auto const& move : report.moves)
+        EXPECT_EQ(move.srcOffset - move.dstOffset, 128);
+
+    for(auto const& updated : report.updatedAllocs)
+        EXPECT_EQ(ram.size_of(updated), 128);
+
+    EXPECT_EQ(ram.remaining(), 256);
+}
+
+DATA_TEST(sharded_miniram, concurrent_no_overlap) {
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr size_t ALLOCS_PER_THREAD = 64;
+    constexpr size_t ALLOC_SIZE = 16;
+
+    sharded_miniram ram(THREAD_COUNT * ALLOCS_PER_THREAD * ALLOC_SIZE, 4, 16);
+
+    std::vector<std::vector<mini_alloc>> results(THREAD_COUNT);
+    {
+        std::vector<std::jthread> threads;
+        for(size_t i = 0; i < THREAD_COUNT; ++i)
+            threads.emplace_back([&, i] {
+                for(size_t j = 0; j < ALLOCS_PER_THREAD; ++j)
+                    results[i].push_back(ram.allocate(ALLOC_SIZE));
+            });
+    }
+
+    std::vector<mini_alloc> all{};
+    for(auto const& result : results)
+        all.append_range(result);
+
+    for(auto const& alloc : all)
+        ASSERT_NE(alloc.id, sharded_miniram::INVALID_INDEX);
+
+    std::ranges::sort(all, {}, &mini_alloc::offset);
+    for(size_t i = 1; i < all.size(); ++i)
+        EXPECT_GE(all[i].offset, all[i - 1].offset + ALLOC_SIZE);
+
+    EXPECT_EQ(ram.remaining(), 0);
+
+    {
+        std::vector<std::jthread> threads;
+        for(size_t i = 0; i < THREAD_COUNT; ++i)
+            threads.emplace_back([&, i] {
+                for(auto const& alloc : results[i])
+                    ram.free(alloc);
+            });
+    }
+
+    EXPECT_EQ(ram.remaining(), ram.capacity());
+}
+
+}
@@ -0,0 +1,93 @@
+#include "cth/data/thread_caches.hpp"
+#include "test.hpp"
+
+#include <latch>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+
+namespace cth::dt {
+
+namespace {
+    struct counter_cache {
+        int value = 0;
+    };
+
+    size_t local_directory_size() { return dev::thread_cache_directory::local()->caches.size(); }
+}
+
+DATA_TEST(thread_caches, one_cache_per_thread) {
+    dev::thread_caches<counter_cache> caches{};
+
+    size_t inits = 0;
+    auto const init = [&inits](counter_cache& cache) {
+        cache.value = 1;
+        ++inits;
+    };
+
+    auto& main = caches.local(init);
+    EXPECT_EQ(&main, &caches.local(init));
+    EXPECT_EQ(1, main.value);
+
+    counter_cache* other = nullptr;
+    std::jthread{[&] { other = &caches.local(init); }}.join();
+    EXPECT_NE(&main, other);
+    EXPECT_EQ(2, inits);
+
+    // caches of exited threads are kept
+    std::set<counter_cache*> all{};
+    caches.for_each([&all](counter_cache& cache) { all.insert(&cache); });
+    EXPECT_EQ((std::set{&main, other}), all);
+}
+
+DATA_TEST(thread_caches, alternating_registries) {
+    dev::thread_caches<counter_cache> first{};
+    dev::thread_caches<counter_cache> second{};
+
+    auto const init = [](counter_cache&) {};
+
+    first.local(init).value = 1;
+    second.local(init).value = 2;
+
+    EXPECT_EQ(1, first.local(init).value);
+    EXPECT_EQ(2, second.local(init).value);
+}
+
+DATA_TEST(thread_caches, destruction_prunes_lookups) {
+    auto const init = [](counter_cache&) {};
+    auto const before = local_directory_size();
+
+    for(int i = 0; i < 100; ++i) {
+        auto caches = std::make_unique<dev::thread_caches<counter_cache>>();
+        caches->local(init).value = i;
+    }
+    EXPECT_EQ(before, local_directory_size());
+
+    // a live thread's lookups lose the entries of registries destroyed elsewhere
+    auto caches = std::make_unique<dev::thread_caches<counter_cache>>();
+
+    std::latch registered{1};
+    std::latch destroyed{1};
+    size_t threadBefore = 0;
+    size_t threadAfter = 0;
+
+    std::jthread thread{[&] {
+        threadBefore = local_directory_size();
+        caches->local(init).value = 1;
+        registered.count_down();
+
+        destroyed.wait();
+        threadAfter = local_directory_size();
+    }};
+
+    registered.wait();
+    caches.reset();
+    destroyed.count_down();
+    thread.join();
+
+    EXPECT_EQ(threadBefore, threadAfter);
+}
+
+}
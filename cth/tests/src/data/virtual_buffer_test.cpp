@@ -0,0 +1,56 @@
+#include "cth/data/virtual_buffer.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+
+namespace cth::dt {
+
+DATA_TEST(virtual_buffer, commit_and_decommit) {
+    auto const page = virtual_buffer::page_size();
+    EXPECT_GE(page, virtual_buffer::MIN_PAGE_SIZE);
+
+    virtual_buffer buffer{100 * page + 1};
+
+    EXPECT_EQ(buffer.reserved(), 101 * page);
+    EXPECT_EQ(buffer.committed(), 0);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data()) % page, 0);
+
+    buffer.commit(page + 1);
+    EXPECT_EQ(buffer.committed(), 2 * page);
+    std::ranges::fill_n(buffer.data(), 2 * page, std::byte{42});
+
+    buffer.commit(page);
+    EXPECT_EQ(buffer.committed(), 2 * page);
+
+    auto* const data = buffer.data();
+    buffer.commit(buffer.reserved());
+    EXPECT_EQ(buffer.data(), data);
+    EXPECT_EQ(buffer.data()[page], std::byte{42});
+
+    buffer.decommit(page);
+    EXPECT_EQ(buffer.committed(), page);
+    EXPECT_EQ(buffer.data()[0], std::byte{42});
+
+    // decommitted pages come back zeroed
+    buffer.commit(2 * page);
+    EXPECT_EQ(buffer.data()[page], std::byte{0});
+}
+
+DATA_TEST(virtual_buffer, move) {
+    virtual_buffer a{virtual_buffer::page_size()};
+    a.commit(1);
+    auto* const data = a.data();
+
+    virtual_buffer b{std::move(a)};
+    EXPECT_EQ(a.data(), nullptr);
+    EXPECT_EQ(b.data(), data);
+    EXPECT_EQ(b.committed(), virtual_buffer::page_size());
+
+    a = std::move(b);
+    EXPECT_EQ(a.data(), data);
+    EXPECT_EQ(b.reserved(), 0);
+}
+
+}
@@ -11,7 +11,7 @@
 #include "native_handle_helpers.hpp"
 
 
-#include <cth/data/pool.hpp>
+#include <cth/data/concurrent_pool.hpp>
 #include <cth/win/coro/timer.hpp>
 
 namespace cth::co {
@@ -64,23 +64,12 @@ public:
     }
 
 private:
-    void release(timer_t& timer) {
-        std::scoped_lock _{_poolMtx};
-        _pool.release(timer);
-    }
-    timer_t& new_timer() {
-        std::scoped_lock _{_poolMtx};
-
-        if(_pool.exhausted())
-            _pool.emplace(_ctx);
-
-        return _pool.acquire();
-    }
+    void release(timer_t& timer) { _pool.release(timer); }
+    timer_t& new_timer() { return _pool.acquire_or_emplace(_ctx); }
 
     bas::io_context& _ctx;
 
-    std::mutex _poolMtx;
-    dt::pool<dev::adapted_timer> _pool{};
+    dt::concurrent_pool<dev::adapted_timer> _pool{};
 };
 
 }
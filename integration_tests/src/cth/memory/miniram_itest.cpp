@@ -1,17 +1,24 @@
 #include "cth/test.hpp"
 
+#include "cth/data/lifetime_miniram.hpp"
+#include "cth/data/mini_mover.hpp"
 #include "cth/data/miniram.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <map>
 #include <random>
+#include <thread>
+#include <type_traits>
 
 #define MEM_TEST(suite, test_name) CTH_EX_TEST(_mem, suite, test_name)
 
 namespace cth::dt {
 
 
-void gen_hist(miniram const& ram) {
+template<class Ram>
+void gen_hist(Ram const& ram) {
     std::println();
     std::println("Total Free Space: {}kb", ram.remaining() / 1024);
     std::println("Largest Free Region: {}kb", ram.max_alloc() / 1024);
@@ -106,4 +113,469 @@ MEM_TEST(miniram, FragmentationStressTest) {
     gen_hist(ram);
 }
 
+MEM_TEST(miniram, BatchChurnBenchmark) {
+    constexpr uint32_t ramSize = 1024 * 1024 * 256;
+    constexpr size_t batchSize = 4096;
+    constexpr size_t frames = 200;
+    constexpr uint32_t maxAllocSize = 1024 * 2;
+
+    std::mt19937 gen(1337);
+    std::uniform_int_distribution<uint32_t> sizeDist(1, maxAllocSize);
+
+    std::vector<std::vector<size_t>> frameSizes(frames);
+    for(auto& sizes : frameSizes)
+        for(size_t i = 0; i < batchSize; ++i)
+            sizes.push_back(sizeDist(gen));
+
+    auto const measure = [&](auto&& frame_fn) {
+        miniram ram(ramSize, 1024);
+        std::vector<mini_alloc> live{};
+
+        auto const start = std::chrono::steady_clock::now();
+        for(auto const& sizes : frameSizes)
+            frame_fn(ram, live, sizes);
+        std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - start;
+
+        return elapsed.count() / static_cast<double>(frames * batchSize * 2);
+    };
+
+    auto const singleNs = measure([](miniram& ram, std::vector<mini_alloc>& live, auto const& sizes) {
+        for(auto const& alloc : live)
+            ram.free(alloc);
+        live.clear();
+
+        for(auto const size : sizes)
+            live.push_back(ram.allocate(size));
+    });
+
+    auto const batchedNs = measure([](miniram& ram, std::vector<mini_alloc>& live, auto const& sizes) {
+        ram.free_n(live);
+        live = ram.allocate_n(sizes);
+    });
+
+    std::println();
+    std::println("--- Batch Churn Benchmark ({} frames, {} allocs / frame) ---", frames, batchSize);
+    std::println("single:  {:.2f} ns/op", singleNs);
+    std::println("batched: {:.2f} ns/op", batchedNs);
+}
+
+MEM_TEST(miniram, NodeLayoutBenchmark) {
+    constexpr uint32_t ramSize = 1024 * 1024 * 256;
+    constexpr uint32_t numOperations = 300000;
+    constexpr uint32_t maxAllocSize = 1024 * 2;
+    constexpr int allocChancePercent = 70;
+
+    struct result {
+        double opNs;
+        double defragMs;
+    };
+
+    auto const measure = [&]<class Ram>(std::type_identity<Ram>) {
+        Ram ram(ramSize);
+        std::vector<mini_alloc> live;
+        live.reserve(numOperations);
+
+        // same pattern for every layout
+        std::mt19937 gen(1337);
+        std::uniform_int_distribution<> opDist(0, 99);
+        std::uniform_int_distribution<uint32_t> sizeDist(1, maxAllocSize);
+
+        auto const start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < numOperations; ++i) {
+            if(opDist(gen) < allocChancePercent) {
+                auto const alloc = ram.allocate(sizeDist(gen));
+                if(alloc.id != Ram::INVALID_INDEX)
+                    live.push_back(alloc);
+            } else if(!live.empty()) {
+                std::uniform_int_distribution<size_t> freeDist(0, live.size() - 1);
+                auto const index = freeDist(gen);
+
+                ram.free(live[index]);
+                std::swap(live[index], live.back());
+                live.pop_back();
+            }
+        }
+        std::chrono::duration<double, std::nano> const opTime = std::chrono::steady_clock::now() - start;
+
+        auto const defragStart = std::chrono::steady_clock::now();
+        auto const report = ram.defragment();
+        std::chrono::duration<double, std::milli> const defragTime =
+            std::chrono::steady_clock::now() - defragStart;
+
+        EXPECT_EQ(report.updatedAllocs.size(), live.size());
+
+        return result{opTime.count() / numOperations, defragTime.count()};
+    };
+
+    auto const aos = measure(std::type_identity<miniram>{});
+    auto const soa = measure(std::type_identity<miniram_soa>{});
+
+    std::println();
+    std::println("--- Node Layout Benchmark ({} operations) ---", numOperations);
+    std::println("{:>6} | {:>10} | {:>12}", "layout", "ns/op", "defrag (ms)");
+    std::println("{:>6} | {:>10.2f} | {:>12.3f}", "aos", aos.opNs, aos.defragMs);
+    std::println("{:>6} | {:>10.2f} | {:>12.3f}", "soa", soa.opNs, soa.defragMs);
+}
+
+MEM_TEST(miniram, PlacementPolicyComparison) {
+    constexpr uint32_t ramSize = 1024 * 1024 * 256;
+    constexpr uint32_t numOperations = 300000;
+    constexpr uint32_t maxAllocSize = 1024 * 2;
+    constexpr int allocChancePercent = 70;
+
+    auto const run = [&]<MiniPlacement Placement>(char const* name) {
+        basic_miniram<size_t, uint32_t, mini_config{.placement = Placement}> ram(ramSize);
+        std::vector<mini_alloc> live;
+        live.reserve(numOperations);
+
+        // same pattern for every policy
+        std::mt19937 gen(1337);
+        std::uniform_int_distribution<> opDist(0, 99);
+        std::uniform_int_distribution<uint32_t> sizeDist(1, maxAllocSize);
+
+        auto const start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < numOperations; ++i) {
+            if(opDist(gen) < allocChancePercent) {
+                auto const alloc = ram.allocate(sizeDist(gen));
+                if(alloc.id != miniram::INVALID_INDEX)
+                    live.push_back(alloc);
+            } else if(!live.empty()) {
+                std::uniform_int_distribution<size_t> freeDist(0, live.size() - 1);
+                auto const index = freeDist(gen);
+
+                ram.free(live[index]);
+                std::swap(live[index], live.back());
+                live.pop_back();
+            }
+        }
+        std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - start;
+
+        std::println();
+        std::println(
+            "--- {} ({:.2f} ns/op, fragmentation {:.4f}) ---",
+            name,
+            elapsed.count() / numOperations,
+            ram.fragmentation()
+        );
+        gen_hist(ram);
+    };
+
+    run.template operator()<MiniPlacement::GOOD_FIT>("good fit");
+    run.template operator()<MiniPlacement::BEST_FIT>("best fit");
+    run.template operator()<MiniPlacement::LOWEST_ADDRESS>("lowest address");
+}
+
+MEM_TEST(miniram, BinGranularityBenchmark) {
+    constexpr uint32_t ramSize = 1024 * 1024 * 64; // small enough to run full
+    constexpr uint32_t numOperations = 300000;
+    constexpr uint32_t maxAllocSize = 1024 * 2;
+    constexpr int allocChancePercent = 70;
+
+    std::println();
+    std::println("--- Bin Granularity Benchmark ({} operations) ---", numOperations);
+    std::println(
+        "{:>6} | {:>10} | {:>10} | {:>13} | {:>14}",
+        "bins",
+        "ns/op",
+        "failed",
+        "fragmentation",
+        "max alloc (kb)"
+    );
+
+    auto const run = [&]<size_t BinsPerLeaf>() {
+        using ram_t = basic_miniram<size_t, uint32_t, mini_config{.binsPerLeaf = BinsPerLeaf}>;
+        ram_t ram(ramSize);
+        std::vector<mini_alloc> live;
+        live.reserve(numOperations);
+
+        std::mt19937 gen(1337);
+        std::uniform_int_distribution<> opDist(0, 99);
+        std::uniform_int_distribution<uint32_t> sizeDist(1, maxAllocSize);
+
+        size_t failed = 0;
+
+        auto const start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < numOperations; ++i) {
+            if(opDist(gen) < allocChancePercent) {
+                auto const alloc = ram.allocate(sizeDist(gen));
+                if(alloc.id != miniram::INVALID_INDEX)
+                    live.push_back(alloc);
+                else
+                    ++failed;
+            } else if(!live.empty()) {
+                std::uniform_int_distribution<size_t> freeDist(0, live.size() - 1);
+                auto const index = freeDist(gen);
+
+                ram.free(live[index]);
+                std::swap(live[index], live.back());
+                live.pop_back();
+            }
+        }
+        std::chrono::duration<double, std::nano> const elapsed = std::chrono::steady_clock::now() - start;
+
+        std::println(
+            "{:>6} | {:>10.2f} | {:>10} | {:>13.4f} | {:>14}",
+            BinsPerLeaf,
+            elapsed.count() / numOperations,
+            failed,
+            ram.fragmentation(),
+            ram.max_alloc() / 1024
+        );
+    };
+
+    run.template operator()<4>();
+    run.template operator()<8>();
+    run.template operator()<16>();
+    run.template operator()<32>();
+    run.template operator()<64>();
+}
+
+MEM_TEST(mini_mover, CompactionBandwidth) {
+    constexpr uint32_t ramSize = 1024 * 1024 * 256; // 256 MB buffer, 1 byte elements
+    constexpr uint32_t maxAllocSize = 1024 * 64;
+
+    miniram ram(ramSize);
+    std::vector<mini_alloc> allocations{};
+
+    std::mt19937 gen(1337);
+    std::uniform_int_distribution<uint32_t> sizeDist(1, maxAllocSize);
+
+    while(true) {
+        auto const alloc = ram.allocate(sizeDist(gen));
+        if(alloc.id == miniram::INVALID_INDEX)
+            break;
+        allocations.push_back(alloc);
+    }
+
+    for(size_t i = 0; i < allocations.size(); i += 2)
+        ram.free(allocations[i]);
+
+    auto const report = ram.defragment();
+
+    size_t movedBytes = 0;
+    for(auto const& move : report.moves)
+        movedBytes += move.size;
+
+    std::vector<std::byte> memory(ramSize);
+
+    auto const measure = [&](auto&& execute_fn) {
+        auto const start = std::chrono::steady_clock::now();
+        execute_fn();
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(movedBytes) / elapsed.count() / (1024.0 * 1024.0 * 1024.0);
+    };
+
+    auto const sequentialGbs = measure([&] {
+        for(auto const& move : report.moves)
+            std::memmove(memory.data() + move.dstOffset, memory.data() + move.srcOffset, move.size);
+    });
+
+    mini_mover const mover{std::max(std::thread::hardware_concurrency(), 2u)};
+    mini_mover::stats moverStats{};
+    auto const moverGbs = measure([&] { moverStats = mover.execute(report, memory.data(), 1); });
+
+    std::println();
+    std::println(
+        "--- Compaction Bandwidth ({} moves, {} MB moved) ---",
+        report.moves.size(),
+        movedBytes >> 20
+    );
+    std::println("sequential memmove: {:.2f} GB/s", sequentialGbs);
+    std::println("mini_mover:         {:.2f} GB/s", moverGbs);
+    std::println(
+        "mini_mover batches: {} ({} parallel, {} threads)",
+        moverStats.batches,
+        moverStats.parallelBatches,
+        mover.thread_count()
+    );
+}
+
+MEM_TEST(miniram, WarmupGrowthBenchmark) {
+    constexpr size_t initialSize = 1024 * 1024;
+    constexpr size_t growthSteps = 64;
+    constexpr size_t allocsPerStep = 2000;
+    constexpr size_t maxAllocSize = 256;
+
+    auto const run = [&](auto&& grow_fn) {
+        miniram ram(initialSize);
+        std::vector<mini_alloc> live;
+
+        std::mt19937 gen(1337);
+        std::uniform_int_distribution<size_t> sizeDist(1, maxAllocSize);
+
+        size_t movedElements = 0;
+        std::chrono::nanoseconds growTime{};
+
+        for(size_t step = 0; step < growthSteps; ++step) {
+            for(size_t i = 0; i < allocsPerStep; ++i) {
+                auto const alloc = ram.allocate(sizeDist(gen));
+                if(alloc.offset != miniram::NO_SPACE)
+                    live.push_back(alloc);
+            }
+
+            // churn, leaves holes the in place growth keeps
+            for(size_t i = 0; i < live.size(); i += 3) {
+                ram.free(live[i]);
+                live[i] = live.back();
+                live.pop_back();
+            }
+
+            auto const start = std::chrono::steady_clock::now();
+            movedElements += grow_fn(ram, ram.capacity() + initialSize);
+            growTime += std::chrono::steady_clock::now() - start;
+        }
+
+        return std::pair{movedElements, growTime};
+    };
+
+    auto const [defragMoved, defragTime] = run([](miniram& ram, size_t new_capacity) {
+        auto const report = ram.resize(new_capacity);
+
+        size_t moved = 0;
+        for(auto const& move : report.moves)
+            moved += move.size;
+        return moved;
+    });
+
+    auto const [inPlaceMoved, inPlaceTime] = run([](miniram& ram, size_t new_capacity) {
+        ram.resize_in_place(new_capacity);
+        return size_t{0};
+    });
+
+    std::println();
+    std::println("--- Warmup Growth ({} steps) ---", growthSteps);
+    std::println("{:>10} | {:>12} | {:>14}", "resize", "time (ms)", "moved (kb)");
+    std::println("-------------------------------------------");
+    std::println(
+        "{:>10} | {:>12.3f} | {:>14}",
+        "defrag",
+        std::chrono::duration<double, std::milli>(defragTime).count(),
+        defragMoved / 1024
+    );
+    std::println(
+        "{:>10} | {:>12.3f} | {:>14}",
+        "in place",
+        std::chrono::duration<double, std::milli>(inPlaceTime).count(),
+        inPlaceMoved / 1024
+    );
+}
+
+MEM_TEST(miniram, SnapshotRestoreBenchmark) {
+    constexpr uint32_t ramSize = 1024 * 1024 * 256;
+    constexpr size_t numAllocations = 100000;
+    constexpr uint32_t maxAllocSize = 1024 * 2;
+
+    std::mt19937 gen(1337);
+    std::uniform_int_distribution<uint32_t> sizeDist(1, maxAllocSize);
+
+    std::vector<size_t> sizes(numAllocations);
+    std::ranges::generate(sizes, [&] { return sizeDist(gen); });
+
+    auto const replayStart = std::chrono::steady_clock::now();
+    miniram ram(ramSize);
+    for(auto const size : sizes)
+        static_cast<void>(ram.allocate(size));
+    std::chrono::duration<double, std::milli> const replayTime =
+        std::chrono::steady_clock::now() - replayStart;
+
+    auto const blob = ram.snapshot();
+
+    auto const restoreStart = std::chrono::steady_clock::now();
+    auto const restored = miniram::restore(blob);
+    std::chrono::duration<double, std::milli> const restoreTime =
+        std::chrono::steady_clock::now() - restoreStart;
+
+    EXPECT_EQ(restored.remaining(), ram.remaining());
+
+    std::println();
+    std::println("--- Snapshot Restore ({} allocations, {} kb blob) ---", numAllocations, blob.size() / 1024);
+    std::println("replay:  {:.3f} ms", replayTime.count());
+    std::println("restore: {:.3f} ms", restoreTime.count());
+}
+
+
+MEM_TEST(lifetime_miniram, ScratchSegregationBenchmark) {
+    constexpr uint32_t ramSize = 1024 * 1024 * 64;
+    constexpr size_t frames = 500;
+    constexpr size_t scratchPerFrame = 2000;
+    constexpr size_t residentsPerFrame = 20;
+    constexpr uint32_t maxAllocSize = 1024 * 2;
+
+    struct result {
+        double frameUs;
+        float fragmentation;
+        size_t residentSpan; ///< end of the highest resident block
+    };
+
+    // same frames for both: scratch churn around slowly changing resident blocks
+    auto const run = [&]<class Ram>(Ram& ram, auto&& alloc_scratch, auto&& free_scratch, auto&& frag_fn) {
+        std::mt19937 gen(1337);
+        std::uniform_int_distribution<uint32_t> sizeDist(1, maxAllocSize);
+
+        std::vector<mini_alloc> residents{};
+
+        auto const start = std::chrono::steady_clock::now();
+        for(size_t frame = 0; frame < frames; ++frame) {
+            for(size_t i = 0; i < scratchPerFrame; ++i)
+                alloc_scratch(ram, sizeDist(gen));
+
+            for(size_t i = 0; i < residentsPerFrame; ++i)
+                if(auto const alloc = ram.allocate(sizeDist(gen)); alloc.id != Ram::INVALID_INDEX)
+                    residents.push_back(alloc);
+
+            for(size_t i = 0; i < residentsPerFrame * 3 / 4 && !residents.empty(); ++i) {
+                std::uniform_int_distribution<size_t> indexDist(0, residents.size() - 1);
+                auto const index = indexDist(gen);
+
+                ram.free(residents[index]);
+                residents[index] = residents.back();
+                residents.pop_back();
+            }
+
+            free_scratch(ram);
+        }
+        std::chrono::duration<double, std::micro> const elapsed = std::chrono::steady_clock::now() - start;
+
+        size_t span = 0;
+        for(auto const& alloc : residents)
+            span = std::max<size_t>(span, alloc.offset + ram.size_of(alloc));
+
+        return result{elapsed.count() / frames, frag_fn(ram), span};
+    };
+
+    miniram plain{ramSize};
+    std::vector<mini_alloc> scratch{};
+    auto const plainResult = run(
+        plain,
+        [&](miniram& ram, uint32_t size) { scratch.push_back(ram.allocate(size)); },
+        [&](miniram& ram) {
+            ram.free_n(scratch);
+            scratch.clear();
+        },
+        [](miniram const& ram) { return ram.fragmentation(); }
+    );
+
+    lifetime_miniram segregated{ramSize};
+    auto const segregatedResult = run(
+        segregated,
+        [](lifetime_miniram& ram, uint32_t size) { static_cast<void>(ram.allocate_transient(size)); },
+        [](lifetime_miniram& ram) { ram.free_transient(); },
+        [](lifetime_miniram const& ram) { return ram.resident().fragmentation(); }
+    );
+
+    std::println();
+    std::println("--- Scratch Segregation ({} frames, {} scratch / frame) ---", frames, scratchPerFrame);
+    std::println("{:>12} | {:>12} | {:>14} | {:>12}", "ram", "frame (us)", "fragmentation", "span (kb)");
+    std::println("--------------------------------------------------------------");
+    auto const results = {std::pair{"plain", plainResult}, std::pair{"lifetime", segregatedResult}};
+    for(auto const& [name, res] : results)
+        std::println(
+            "{:>12} | {:>12.2f} | {:>14.4f} | {:>12}",
+            name,
+            res.frameUs,
+            res.fragmentation,
+            res.residentSpan / 1024
+        );
+}
+
 }
@@ -0,0 +1,120 @@
+#include "cth/test.hpp"
+
+#include "cth/data/concurrent_pool.hpp"
+#include "cth/data/pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define MEM_TEST(suite, test_name) CTH_EX_TEST(_mem, suite, test_name)
+
+namespace cth::dt {
+
+namespace {
+    constexpr size_t BENCH_OPS_PER_THREAD = 1'000'000;
+    constexpr size_t BENCH_HELD = 4;
+
+    struct bench_object {
+        std::array<std::byte, 64> payload{};
+    };
+
+    struct bench_resetter {
+        void reset(bench_object& o) { o.payload.front() = std::byte{}; }
+    };
+
+    /**
+     * dt::pool behind a mutex, the pattern concurrent_pool replaces
+     */
+    class locked_pool {
+    public:
+        bench_object& acquire() {
+            std::scoped_lock lock{_mutex};
+            if(_pool.exhausted())
+                _pool.emplace();
+            return _pool.acquire();
+        }
+        void release(bench_object& o) {
+            std::scoped_lock lock{_mutex};
+            _pool.release(o);
+        }
+
+    private:
+        std::mutex _mutex;
+        pool<bench_object, bench_resetter> _pool{};
+    };
+
+    /**
+     * every thread keeps a few objects acquired and cycles through acquire / release
+     * @param acquire_fn () -> bench_object&
+     * @param release_fn (bench_object&) -> void
+     * @return million acquire + release pairs per second
+     */
+    template<class AcquireFn, class ReleaseFn>
+    double run_cycles(size_t thread_count, AcquireFn acquire_fn, ReleaseFn release_fn) {
+        auto const start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for(size_t t = 0; t < thread_count; ++t)
+                threads.emplace_back([&acquire_fn, &release_fn] {
+                    std::array<bench_object*, BENCH_HELD> held{};
+                    for(auto& h : held)
+                        h = &acquire_fn();
+
+                    for(size_t i = 0; i < BENCH_OPS_PER_THREAD; ++i) {
+                        auto& slot = held[i % BENCH_HELD];
+                        release_fn(*slot);
+                        slot = &acquire_fn();
+                        slot->payload.back() = std::byte{1};
+                    }
+
+                    for(auto* h : held)
+                        release_fn(*h);
+                });
+        }
+        auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        return static_cast<double>(thread_count * BENCH_OPS_PER_THREAD) / seconds / 1e6;
+    }
+}
+
+MEM_TEST(pool, ConcurrentScaling) {
+    auto const maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1) * 2;
+
+    std::println();
+    std::println(
+        "--- Concurrent Pool Benchmark ({} cycles / thread, {} held / thread) ---",
+        BENCH_OPS_PER_THREAD,
+        BENCH_HELD
+    );
+    std::println("{:>7} | {:>14} | {:>14} | {:>7}", "threads", "mutex (M/s)", "lockfree (M/s)", "speedup");
+
+    for(size_t threads = 1; threads <= std::max<size_t>(maxThreads, 16); threads *= 2) {
+        locked_pool locked{};
+        auto const mutexed = run_cycles(
+            threads,
+            [&locked]() -> bench_object& { return locked.acquire(); },
+            [&locked](bench_object& o) { locked.release(o); }
+        );
+
+        concurrent_pool<bench_object, bench_resetter> concurrent{};
+        auto const lockFree = run_cycles(
+            threads,
+            [&concurrent]() -> bench_object& { return concurrent.acquire_or_emplace(); },
+            [&concurrent](bench_object& o) { concurrent.release(o); }
+        );
+
+        std::println(
+            "{:>7} | {:>14.2f} | {:>14.2f} | {:>6.2f}x",
+            threads,
+            mutexed,
+            lockFree,
+            lockFree / mutexed
+        );
+    }
+}
+
+}
@@ -0,0 +1,128 @@
+#include "cth/test.hpp"
+
+#include "cth/data/ring_queue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#define MEM_TEST(suite, test_name) CTH_EX_TEST(_mem, suite, test_name)
+
+namespace cth::dt {
+
+namespace {
+    constexpr size_t BENCH_QUEUE_SIZE = 1024 * 1024;
+    constexpr size_t BENCH_MESSAGES = 2'000'000;
+    constexpr size_t BENCH_PAYLOAD_SIZE = 64;
+
+    struct queue_result {
+        double mmsgs;
+        double gbs;
+        double p50Ns;
+        double p99Ns;
+    };
+
+    /**
+     * producers push timestamped records, a single consumer drains them
+     * @return throughput and publish to drain latency
+     */
+    template<class Queue>
+    queue_result run_queue(size_t producer_count) {
+        using clock = std::chrono::steady_clock;
+
+        Queue queue{BENCH_QUEUE_SIZE};
+
+        auto const perProducer = BENCH_MESSAGES / producer_count;
+        auto const total = perProducer * producer_count;
+
+        std::vector<int64_t> latencies{};
+        latencies.reserve(total);
+
+        auto const start = clock::now();
+        {
+            std::vector<std::jthread> producers;
+            for(size_t p = 0; p < producer_count; ++p)
+                producers.emplace_back([&queue, perProducer] {
+                    for(size_t i = 0; i < perProducer; ++i) {
+                        auto const write = [](std::span<std::byte> payload) {
+                            auto const stamp = clock::now().time_since_epoch().count();
+                            std::memcpy(payload.data(), &stamp, sizeof(stamp));
+                        };
+
+                        while(!queue.try_emplace(BENCH_PAYLOAD_SIZE, write))
+                            std::this_thread::yield();
+                    }
+                });
+
+            while(latencies.size() < total) {
+                auto const now = clock::now().time_since_epoch().count();
+
+                auto const read = queue.drain([&](std::span<std::byte const> payload) {
+                    int64_t stamp = 0;
+                    std::memcpy(&stamp, payload.data(), sizeof(stamp));
+                    latencies.push_back(std::max<int64_t>(now - stamp, 0));
+                });
+
+                if(read == 0)
+                    std::this_thread::yield();
+            }
+        }
+        auto const seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        std::ranges::sort(latencies);
+        auto const at = [&](size_t percent) {
+            return static_cast<double>(latencies[(latencies.size() - 1) * percent / 100]);
+        };
+
+        return {
+            .mmsgs = static_cast<double>(total) / seconds / 1e6,
+            .gbs = static_cast<double>(total * BENCH_PAYLOAD_SIZE) / seconds / 1e9,
+            .p50Ns = at(50),
+            .p99Ns = at(99),
+        };
+    }
+
+    void print_result(char const* name, size_t producers, queue_result const& result) {
+        std::println(
+            "{:>6} | {:>9} | {:>10.2f} | {:>8.2f} | {:>10.0f} | {:>10.0f}",
+            name,
+            producers,
+            result.mmsgs,
+            result.gbs,
+            result.p50Ns,
+            result.p99Ns
+        );
+    }
+}
+
+MEM_TEST(ring_queue, ThroughputAndLatency) {
+    auto const threads = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+    auto const multiProducers = std::min<size_t>(threads - 1, 4);
+
+    std::println();
+    std::println(
+        "--- Ring Queue Benchmark ({} messages, {}b payload, {}kb ring) ---",
+        BENCH_MESSAGES,
+        BENCH_PAYLOAD_SIZE,
+        BENCH_QUEUE_SIZE / 1024
+    );
+    std::println(
+        "{:>6} | {:>9} | {:>10} | {:>8} | {:>10} | {:>10}",
+        "queue",
+        "producers",
+        "Mmsg/s",
+        "GB/s",
+        "p50 (ns)",
+        "p99 (ns)"
+    );
+
+    // single producer path vs. the CAS + per header publication path with the same load
+    print_result("spsc", 1, run_queue<spsc_ring_queue>(1));
+    print_result("mpsc", 1, run_queue<mpsc_ring_queue>(1));
+    print_result("mpsc", multiProducers, run_queue<mpsc_ring_queue>(multiProducers));
+    print_result("mpmc", multiProducers, run_queue<mpmc_ring_queue>(multiProducers));
+}
+
+}
@@ -0,0 +1,99 @@
+#include "cth/test.hpp"
+
+#include "cth/data/ringalloc.hpp"
+
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#define MEM_TEST(suite, test_name) CTH_EX_TEST(_mem, suite, test_name)
+
+namespace cth::dt {
+
+namespace {
+    constexpr size_t BENCH_ALLOCS_PER_THREAD = 500'000;
+    constexpr size_t BENCH_ALLOCS_PER_BATCH = 5'000;
+    constexpr size_t BENCH_ALLOC_SIZE = 64;
+    constexpr size_t BENCH_CHUNK_SIZE = 64 * 1024;
+
+    /**
+     * every thread allocates in batches, a batch is freed once every thread finished it
+     * @param alloc_fn (ring_alloc&) -> cleanup_t, allocates one batch of a thread, returns the last token
+     * @return million allocations per second
+     * @note reservations must be flushed at the end of the batch, see the reservation free order
+     */
+    template<class AllocFn>
+    double run_producers(size_t thread_count, AllocFn alloc_fn) {
+        auto const batchBytes = BENCH_ALLOCS_PER_BATCH * BENCH_ALLOC_SIZE + 2 * BENCH_CHUNK_SIZE;
+        ring_alloc ring{thread_count * batchBytes * 2};
+
+        // last token of every thread's batch, the furthest one frees the batch
+        std::vector<cleanup_t> batchEnds(thread_count);
+        std::barrier sync{static_cast<std::ptrdiff_t>(thread_count), [&ring, &batchEnds]() noexcept {
+            ring.free(std::ranges::max(batchEnds));
+        }};
+
+        auto const start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for(size_t t = 0; t < thread_count; ++t)
+                threads.emplace_back([&ring, &alloc_fn, &batchEnds, &sync, t] {
+                    for(size_t i = 0; i < BENCH_ALLOCS_PER_THREAD; i += BENCH_ALLOCS_PER_BATCH) {
+                        batchEnds[t] = alloc_fn(ring);
+                        sync.arrive_and_wait();
+                    }
+                });
+        }
+        auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        return static_cast<double>(thread_count * BENCH_ALLOCS_PER_THREAD) / seconds / 1e6;
+    }
+}
+
+MEM_TEST(ring_alloc, ReservationContention) {
+    auto const maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1) * 2;
+
+    std::println();
+    std::println(
+        "--- Ring Alloc Reservation Benchmark ({} allocs / thread, {}b allocs, {}kb chunks) ---",
+        BENCH_ALLOCS_PER_THREAD,
+        BENCH_ALLOC_SIZE,
+        BENCH_CHUNK_SIZE / 1024
+    );
+    std::println("{:>7} | {:>12} | {:>12} | {:>7}", "threads", "cas (M/s)", "chunk (M/s)", "speedup");
+
+    for(size_t threads = 1; threads <= std::max<size_t>(maxThreads, 16); threads *= 2) {
+        auto const cas = run_producers(threads, [](ring_alloc& ring) {
+            cleanup_t last{};
+            for(size_t i = 0; i < BENCH_ALLOCS_PER_BATCH; ++i) {
+                auto const result = ring.alloc(BENCH_ALLOC_SIZE);
+                if(!result)
+                    std::terminate();
+                last = result->cleanup;
+            }
+            return last;
+        });
+
+        auto const chunked = run_producers(threads, [](ring_alloc& ring) {
+            // flushed on destruction, before the batch is freed
+            ring_alloc::reservation reservation{ring, BENCH_CHUNK_SIZE};
+
+            cleanup_t last{};
+            for(size_t i = 0; i < BENCH_ALLOCS_PER_BATCH; ++i) {
+                auto const result = reservation.alloc(BENCH_ALLOC_SIZE);
+                if(!result)
+                    std::terminate();
+                last = result->cleanup;
+            }
+            return last;
+        });
+
+        std::println("{:>7} | {:>12.2f} | {:>12.2f} | {:>6.2f}x", threads, cas, chunked, chunked / cas);
+    }
+}
+
+}
@@ -0,0 +1,186 @@
+#include "cth/test.hpp"
+
+#include "cth/data/cached_miniram.hpp"
+#include "cth/data/miniram.hpp"
+#include "cth/data/sharded_miniram.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define MEM_TEST(suite, test_name) CTH_EX_TEST(_mem, suite, test_name)
+
+namespace cth::dt {
+
+namespace {
+    constexpr uint32_t BENCH_RAM_SIZE = 1024 * 1024 * 256;
+    constexpr uint32_t BENCH_OPS_PER_THREAD = 200000;
+    constexpr uint32_t BENCH_MAX_ALLOC_SIZE = 1024 * 2;
+
+    /**
+     * baseline, single mutex around the whole allocator
+     */
+    class locked_miniram {
+    public:
+        explicit locked_miniram(uint32_t capacity) : _ram{capacity} {}
+
+        [[nodiscard]] mini_alloc allocate(size_t size) {
+            std::scoped_lock lock{_mutex};
+            return _ram.allocate(size);
+        }
+
+        void free(mini_alloc allocation) {
+            std::scoped_lock lock{_mutex};
+            _ram.free(allocation);
+        }
+
+    private:
+        std::mutex _mutex;
+        miniram _ram;
+    };
+
+    /**
+     * runs the random alloc / free pattern of the fragmentation stress test on every thread
+     * @return million operations per second
+     */
+    template<class Ram>
+    double run_throughput(Ram& ram, size_t thread_count) {
+        auto const start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for(size_t t = 0; t < thread_count; ++t)
+                threads.emplace_back([&ram, t] {
+                    std::mt19937 gen(static_cast<uint32_t>(t));
+                    std::uniform_int_distribution<> opDist(0, 99);
+                    std::uniform_int_distribution<uint32_t> sizeDist(1, BENCH_MAX_ALLOC_SIZE);
+
+                    std::vector<mini_alloc> live;
+                    live.reserve(BENCH_OPS_PER_THREAD);
+
+                    for(uint32_t i = 0; i < BENCH_OPS_PER_THREAD; ++i) {
+                        if(opDist(gen) < 55 || live.empty()) {
+                            auto const alloc = ram.allocate(sizeDist(gen));
+                            if(alloc.id != miniram::INVALID_INDEX)
+                                live.push_back(alloc);
+                            continue;
+                        }
+
+                        std::uniform_int_distribution<size_t> freeDist(0, live.size() - 1);
+                        auto const index = freeDist(gen);
+
+                        ram.free(live[index]);
+                        std::swap(live[index], live.back());
+                        live.pop_back();
+                    }
+
+                    for(auto const& alloc : live)
+                        ram.free(alloc);
+                });
+        }
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+        return static_cast<double>(thread_count * BENCH_OPS_PER_THREAD) / elapsed.count() / 1e6;
+    }
+
+    constexpr uint32_t SMALL_BENCH_MAX_ALLOC_SIZE = 128;
+    constexpr uint32_t SMALL_BENCH_LIVE_BLOCKS = 256;
+
+    /**
+     * churns a small working set of small blocks on every thread, sized frees
+     * @return nanoseconds per operation (alloc or free)
+     */
+    template<class Ram>
+    double run_small_blocks(Ram& ram, size_t thread_count) {
+        auto const start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for(size_t t = 0; t < thread_count; ++t)
+                threads.emplace_back([&ram, t] {
+                    std::mt19937 gen(static_cast<uint32_t>(t));
+                    std::uniform_int_distribution<uint32_t> sizeDist(1, SMALL_BENCH_MAX_ALLOC_SIZE);
+                    std::uniform_int_distribution<size_t> slotDist(0, SMALL_BENCH_LIVE_BLOCKS - 1);
+
+                    std::vector<std::pair<mini_alloc, uint32_t>> live(
+                        SMALL_BENCH_LIVE_BLOCKS,
+                        {{miniram::NO_SPACE, miniram::INVALID_INDEX}, 0}
+                    );
+
+                    for(uint32_t i = 0; i < BENCH_OPS_PER_THREAD / 2; ++i) {
+                        auto& [alloc, size] = live[slotDist(gen)];
+                        if(alloc.id != miniram::INVALID_INDEX)
+                            ram.free(alloc, size);
+
+                        size = sizeDist(gen);
+                        alloc = ram.allocate(size);
+                    }
+
+                    for(auto const& [alloc, size] : live)
+                        if(alloc.id != miniram::INVALID_INDEX)
+                            ram.free(alloc, size);
+                });
+        }
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+        return elapsed.count() * 1e9 / static_cast<double>(thread_count * BENCH_OPS_PER_THREAD);
+    }
+
+    /**
+     * adapts the unsized free of @ref sharded_miniram to @ref run_small_blocks
+     */
+    struct sized_sharded_miniram {
+        sharded_miniram ram;
+
+        [[nodiscard]] mini_alloc allocate(size_t size) { return ram.allocate(size); }
+        void free(mini_alloc allocation, size_t) { ram.free(allocation); }
+    };
+}
+
+
+MEM_TEST(sharded_miniram, ThroughputBenchmark) {
+    std::println();
+    std::println("--- Sharded Miniram Throughput (Mops/s) ---");
+    std::println("{:>8} | {:>12} | {:>12}", "threads", "locked", "sharded");
+
+    auto const maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for(size_t threads = 1; threads <= std::max<size_t>(maxThreads, 16); threads *= 2) {
+        locked_miniram locked{BENCH_RAM_SIZE};
+        sharded_miniram sharded{BENCH_RAM_SIZE};
+
+        auto const lockedMops = run_throughput(locked, threads);
+        auto const shardedMops = run_throughput(sharded, threads);
+
+        EXPECT_EQ(sharded.remaining(), sharded.capacity());
+
+        std::println("{:>8} | {:>12.2f} | {:>12.2f}", threads, lockedMops, shardedMops);
+    }
+    std::println("-------------------------------------------");
+}
+
+
+MEM_TEST(cached_miniram, SmallBlockBenchmark) {
+    std::println();
+    std::println("--- Small Block Alloc / Free (ns/op) ---");
+    std::println("{:>8} | {:>12} | {:>12}", "threads", "sharded", "cached");
+
+    auto const maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for(size_t threads = 1; threads <= std::max<size_t>(maxThreads, 16); threads *= 2) {
+        sized_sharded_miniram sharded{sharded_miniram{BENCH_RAM_SIZE}};
+        cached_miniram cached{BENCH_RAM_SIZE};
+
+        auto const shardedNs = run_small_blocks(sharded, threads);
+        auto const cachedNs = run_small_blocks(cached, threads);
+
+        cached.flush_all();
+        EXPECT_EQ(sharded.ram.remaining(), sharded.ram.capacity());
+        EXPECT_EQ(cached.remaining(), cached.capacity());
+
+        std::println("{:>8} | {:>12.1f} | {:>12.1f}", threads, shardedNs, cachedNs);
+    }
+    std::println("----------------------------------------");
+}
+
+}
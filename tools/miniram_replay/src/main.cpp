@@ -0,0 +1,113 @@
+// replays a recorded miniram trace (see cth/data/mini_trace.hpp) against every allocator configuration
+// usage: miniram_replay <trace file> [initial alloc capacity]
+
+#include "cth/data/mini_trace.hpp"
+#include "cth/io/file.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <print>
+#include <string>
+#include <utility>
+
+namespace {
+using namespace cth::dt;
+
+constexpr std::array BIN_COUNTS{size_t{4}, size_t{8}, size_t{16}, size_t{64}};
+constexpr std::array LAYOUTS{MiniNodeLayout::AOS, MiniNodeLayout::SOA};
+constexpr std::array PLACEMENTS{
+    MiniPlacement::GOOD_FIT,
+    MiniPlacement::BEST_FIT,
+    MiniPlacement::LOWEST_ADDRESS,
+};
+
+constexpr auto CONFIGS = [] {
+    std::array<mini_config, LAYOUTS.size() * PLACEMENTS.size() * BIN_COUNTS.size()> configs{};
+
+    size_t i = 0;
+    for(auto const layout : LAYOUTS)
+        for(auto const placement : PLACEMENTS)
+            for(auto const bins : BIN_COUNTS)
+                configs[i++] = {.layout = layout, .placement = placement, .binsPerLeaf = bins};
+
+    return configs;
+}();
+
+char const* to_string(MiniNodeLayout layout) { return layout == MiniNodeLayout::AOS ? "aos" : "soa"; }
+
+char const* to_string(MiniPlacement placement) {
+    switch(placement) {
+        case MiniPlacement::GOOD_FIT: return "good fit";
+        case MiniPlacement::BEST_FIT: return "best fit";
+        case MiniPlacement::LOWEST_ADDRESS: return "lowest address";
+    }
+    return "";
+}
+
+template<mini_config Config>
+void replay_row(mini_trace const& trace, size_t initial_alloc_capacity) {
+    auto const report = mini_replay<basic_miniram<size_t, uint32_t, Config>>(trace, initial_alloc_capacity);
+
+    std::println(
+        "{:>4} | {:>14} | {:>4} | {:>8} | {:>8} | {:>8} | {:>8} | {:>10.3f} | {:>8} | {:>12} | {:>10.2f}",
+        to_string(Config.layout),
+        to_string(Config.placement),
+        Config.binsPerLeaf,
+        report.all.p50.count(),
+        report.all.p90.count(),
+        report.all.p99.count(),
+        report.all.max.count(),
+        report.peakFragmentation,
+        report.failedAllocs,
+        report.movedElements,
+        std::chrono::duration<double, std::milli>(report.total).count()
+    );
+}
+
+}
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        std::println(stderr, "usage: miniram_replay <trace file> [initial alloc capacity]");
+        return 1;
+    }
+
+    try {
+        auto const trace = mini_trace::deserialize(cth::io::file::read<std::byte>(argv[1]));
+        size_t const initialAllocCapacity = argc > 2 ? std::stoull(argv[2]) : 128 * 1024;
+
+        std::println(
+            "trace: {} events, {} allocations, capacity {}",
+            trace.events.size(),
+            trace.allocations,
+            trace.capacity
+        );
+        std::println();
+        std::println(
+            "{:>4} | {:>14} | {:>4} | {:>8} | {:>8} | {:>8} | {:>8} | {:>10} | {:>8} | {:>12} | {:>10}",
+            "node",
+            "placement",
+            "bins",
+            "p50 ns",
+            "p90 ns",
+            "p99 ns",
+            "max ns",
+            "peak frag",
+            "failed",
+            "moved",
+            "total ms"
+        );
+        std::println("{}", std::string(124, '-'));
+
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (replay_row<CONFIGS[I]>(trace, initialAllocCapacity), ...);
+        }(std::make_index_sequence<CONFIGS.size()>{});
+    } catch(std::exception const& e) {
+        std::println(stderr, "replay failed: {}", e.what());
+        return 1;
+    }
+
+    return 0;
+}